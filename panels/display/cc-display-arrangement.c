@@ -31,6 +31,9 @@ struct _CcDisplayArrangement
 
   cairo_matrix_t    to_widget;
   cairo_matrix_t    to_actual;
+  gboolean          matrices_valid;
+  gint              matrices_width;
+  gint              matrices_height;
 
   gboolean          drag_active;
   CcDisplayMonitor *selected_output;
@@ -40,6 +43,7 @@ struct _CcDisplayArrangement
   gdouble           drag_anchor_y;
 
   guint             major_snap_distance;
+  struct _SnapIndex *snap_index;
 };
 
 typedef struct _CcDisplayArrangement CcDisplayArrangement;
@@ -68,6 +72,33 @@ typedef struct {
   SnapDirection      snapped;
 } SnapData;
 
+typedef struct {
+  gint x1, y1, x2, y2;
+} SnapRect;
+
+typedef struct {
+  gint  pos;
+  guint rect;
+} SnapEdge;
+
+enum {
+  EDGE_LEFT,
+  EDGE_RIGHT,
+  EDGE_TOP,
+  EDGE_BOTTOM,
+  N_EDGES
+};
+
+/* The geometry of all monitors that can be snapped to, with their edges
+ * sorted per side. The other monitors do not move while dragging, so this
+ * is built once per drag and lets each motion event only look at monitors
+ * that have an edge within the snapping distance. */
+typedef struct _SnapIndex {
+  GArray *rects;            /* SnapRect, in monitor list order */
+  GArray *edges[N_EDGES];   /* SnapEdge, sorted by position */
+  GArray *candidates;       /* gboolean per rect, scratch space */
+} SnapIndex;
+
 #define MARGIN_PX  0
 #define MARGIN_MON  0.66
 #define MAJOR_SNAP_DISTANCE 25
@@ -317,34 +348,49 @@ maybe_update_snap (SnapData       *snap_data,
     }
 }
 
+static gint
+compare_snap_edges (gconstpointer a,
+                    gconstpointer b)
+{
+  const SnapEdge *edge_a = a;
+  const SnapEdge *edge_b = b;
+
+  return (edge_a->pos > edge_b->pos) - (edge_a->pos < edge_b->pos);
+}
+
 static void
-find_best_snapping (CcDisplayConfig   *config,
-                    CcDisplayMonitor  *snap_output,
-                    SnapData          *snap_data)
+snap_index_free (SnapIndex *index)
 {
-  GList *outputs, *l;
-  gint x1, y1, x2, y2;
-  gint w, h;
+  guint i;
 
-  g_assert (snap_data != NULL);
+  g_array_unref (index->rects);
+  for (i = 0; i < N_EDGES; i++)
+    g_array_unref (index->edges[i]);
+  g_array_unref (index->candidates);
+  g_free (index);
+}
 
-  get_scaled_geometry (config, snap_output, &x1, &y1, &w, &h);
-  x2 = x1 + w;
-  y2 = y1 + h;
+static SnapIndex *
+snap_index_new (CcDisplayConfig  *config,
+                CcDisplayMonitor *snap_output)
+{
+  SnapIndex *index;
+  GList *outputs, *l;
+  guint i;
 
-#define OVERLAP(_s1, _s2, _t1, _t2) ((_s1) <= (_t2) && (_t1) <= (_s2))
+  index = g_new0 (SnapIndex, 1);
+  index->rects = g_array_new (FALSE, FALSE, sizeof (SnapRect));
+  for (i = 0; i < N_EDGES; i++)
+    index->edges[i] = g_array_new (FALSE, FALSE, sizeof (SnapEdge));
+  index->candidates = g_array_new (FALSE, TRUE, sizeof (gboolean));
 
   outputs = cc_display_config_get_monitors (config);
   for (l = outputs; l; l = l->next)
     {
       CcDisplayMonitor *output = l->data;
-      gint _x1, _y1, _x2, _y2, _h, _w;
-      gint bottom_snap_pos;
-      gint top_snap_pos;
-      gint left_snap_pos;
-      gint right_snap_pos;
-      gdouble dist_x, dist_y;
-      gdouble tmp;
+      SnapRect rect;
+      SnapEdge edge;
+      gint w, h;
 
       if (output == snap_output)
         continue;
@@ -352,86 +398,222 @@ find_best_snapping (CcDisplayConfig   *config,
       if (!cc_display_monitor_is_useful (output))
         continue;
 
-      get_scaled_geometry (config, output, &_x1, &_y1, &_w, &_h);
-      _x2 = _x1 + _w;
-      _y2 = _y1 + _h;
+      get_scaled_geometry (config, output, &rect.x1, &rect.y1, &w, &h);
+      rect.x2 = rect.x1 + w;
+      rect.y2 = rect.y1 + h;
+
+      edge.rect = index->rects->len;
+      g_array_append_val (index->rects, rect);
+
+      edge.pos = rect.x1;
+      g_array_append_val (index->edges[EDGE_LEFT], edge);
+      edge.pos = rect.x2;
+      g_array_append_val (index->edges[EDGE_RIGHT], edge);
+      edge.pos = rect.y1;
+      g_array_append_val (index->edges[EDGE_TOP], edge);
+      edge.pos = rect.y2;
+      g_array_append_val (index->edges[EDGE_BOTTOM], edge);
+    }
 
-      top_snap_pos = _y1 - h;
-      bottom_snap_pos = _y2;
-      left_snap_pos = _x1 - w;
-      right_snap_pos = _x2;
+  for (i = 0; i < N_EDGES; i++)
+    g_array_sort (index->edges[i], compare_snap_edges);
+  g_array_set_size (index->candidates, index->rects->len);
 
-      dist_y = 9999;
-      /* overlap on the X axis */
-      if (OVERLAP (x1, x2, _x1, _x2))
-        {
-          get_snap_distance (snap_data, x1, y1, x1, top_snap_pos, NULL, &dist_y);
-          get_snap_distance (snap_data, x1, y1, x1, bottom_snap_pos, NULL, &tmp);
-          dist_y = MIN(dist_y, tmp);
-        }
+  return index;
+}
 
-      dist_x = 9999;
-      /* overlap on the Y axis */
-      if (OVERLAP (y1, y2, _y1, _y2))
-        {
-          get_snap_distance (snap_data, x1, y1, left_snap_pos, y1, &dist_x, NULL);
-          get_snap_distance (snap_data, x1, y1, right_snap_pos, y1, &tmp, NULL);
-          dist_x = MIN(dist_x, tmp);
-        }
+/* Marks all rects with an edge between @lower and @upper as candidates */
+static void
+snap_index_mark_edges (SnapIndex *index,
+                       guint      side,
+                       gdouble    lower,
+                       gdouble    upper)
+{
+  GArray *edges = index->edges[side];
+  guint low = 0, high = edges->len;
+  guint i;
 
-      /* We only snap horizontally or vertically to an edge of the same monitor */
-      if (dist_y < dist_x)
-        {
-          maybe_update_snap (snap_data, x1, y1, x1, top_snap_pos, SNAP_DIR_Y, SNAP_DIR_Y, 0);
-          maybe_update_snap (snap_data, x1, y1, x1, bottom_snap_pos, SNAP_DIR_Y, SNAP_DIR_Y, 0);
-        }
-      else if (dist_x < 9999)
-        {
-          maybe_update_snap (snap_data, x1, y1, left_snap_pos, y1, SNAP_DIR_X, SNAP_DIR_X, 0);
-          maybe_update_snap (snap_data, x1, y1, right_snap_pos, y1, SNAP_DIR_X, SNAP_DIR_X, 0);
-        }
+  /* Find the first edge that is not below the lower bound */
+  while (low < high)
+    {
+      guint mid = low + (high - low) / 2;
+
+      if (g_array_index (edges, SnapEdge, mid).pos < lower)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+
+  for (i = low; i < edges->len; i++)
+    {
+      const SnapEdge *edge = &g_array_index (edges, SnapEdge, i);
+
+      if (edge->pos > upper)
+        break;
+
+      g_array_index (index->candidates, gboolean, edge->rect) = TRUE;
+    }
+}
+
+static void
+snap_to_rect (SnapData       *snap_data,
+              gint            x1,
+              gint            y1,
+              gint            x2,
+              gint            y2,
+              const SnapRect *rect)
+{
+  gint _x1, _y1, _x2, _y2;
+  gint w, h;
+  gint bottom_snap_pos;
+  gint top_snap_pos;
+  gint left_snap_pos;
+  gint right_snap_pos;
+  gdouble dist_x, dist_y;
+  gdouble tmp;
+
+#define OVERLAP(_s1, _s2, _t1, _t2) ((_s1) <= (_t2) && (_t1) <= (_s2))
+
+  w = x2 - x1;
+  h = y2 - y1;
+  _x1 = rect->x1;
+  _y1 = rect->y1;
+  _x2 = rect->x2;
+  _y2 = rect->y2;
+
+  top_snap_pos = _y1 - h;
+  bottom_snap_pos = _y2;
+  left_snap_pos = _x1 - w;
+  right_snap_pos = _x2;
+
+  dist_y = 9999;
+  /* overlap on the X axis */
+  if (OVERLAP (x1, x2, _x1, _x2))
+    {
+      get_snap_distance (snap_data, x1, y1, x1, top_snap_pos, NULL, &dist_y);
+      get_snap_distance (snap_data, x1, y1, x1, bottom_snap_pos, NULL, &tmp);
+      dist_y = MIN(dist_y, tmp);
+    }
+
+  dist_x = 9999;
+  /* overlap on the Y axis */
+  if (OVERLAP (y1, y2, _y1, _y2))
+    {
+      get_snap_distance (snap_data, x1, y1, left_snap_pos, y1, &dist_x, NULL);
+      get_snap_distance (snap_data, x1, y1, right_snap_pos, y1, &tmp, NULL);
+      dist_x = MIN(dist_x, tmp);
+    }
+
+  /* We only snap horizontally or vertically to an edge of the same monitor */
+  if (dist_y < dist_x)
+    {
+      maybe_update_snap (snap_data, x1, y1, x1, top_snap_pos, SNAP_DIR_Y, SNAP_DIR_Y, 0);
+      maybe_update_snap (snap_data, x1, y1, x1, bottom_snap_pos, SNAP_DIR_Y, SNAP_DIR_Y, 0);
+    }
+  else if (dist_x < 9999)
+    {
+      maybe_update_snap (snap_data, x1, y1, left_snap_pos, y1, SNAP_DIR_X, SNAP_DIR_X, 0);
+      maybe_update_snap (snap_data, x1, y1, right_snap_pos, y1, SNAP_DIR_X, SNAP_DIR_X, 0);
+    }
+
+  /* Left/right edge identical on the top */
+  maybe_update_snap (snap_data, x1, y1, _x1, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
+  maybe_update_snap (snap_data, x1, y1, _x2 - w, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
+
+  /* Left/right edge identical on the bottom */
+  maybe_update_snap (snap_data, x1, y1, _x1, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
+  maybe_update_snap (snap_data, x1, y1, _x2 - w, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
+
+  /* Top/bottom edge identical on the left */
+  maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y1, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
+  maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y2 - h, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
 
-      /* Left/right edge identical on the top */
-      maybe_update_snap (snap_data, x1, y1, _x1, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
-      maybe_update_snap (snap_data, x1, y1, _x2 - w, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
+  /* Top/bottom edge identical on the right */
+  maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y1, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
+  maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y2 - h, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
+
+  /* If snapping is infinite, then add snapping points with minimal overlap
+   * to prevent detachment.
+   * This is similar to the above but simply re-defines the snapping pos
+   * to have only minimal overlap */
+  if (snap_data->major_snap_distance == G_MAXUINT)
+    {
+      /* Hanging over the left/right edge on the top */
+      maybe_update_snap (snap_data, x1, y1, _x1 - w + MIN_OVERLAP, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 1);
+      maybe_update_snap (snap_data, x1, y1, _x2 - MIN_OVERLAP, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, -1);
 
       /* Left/right edge identical on the bottom */
-      maybe_update_snap (snap_data, x1, y1, _x1, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
-      maybe_update_snap (snap_data, x1, y1, _x2 - w, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
+      maybe_update_snap (snap_data, x1, y1, _x1 - w + MIN_OVERLAP, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 1);
+      maybe_update_snap (snap_data, x1, y1, _x2 - MIN_OVERLAP, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, -1);
 
       /* Top/bottom edge identical on the left */
-      maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y1, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
-      maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y2 - h, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
+      maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y1 - h + MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, 1);
+      maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y2 - MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, -1);
 
       /* Top/bottom edge identical on the right */
-      maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y1, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
-      maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y2 - h, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
-
-      /* If snapping is infinite, then add snapping points with minimal overlap
-       * to prevent detachment.
-       * This is similar to the above but simply re-defines the snapping pos
-       * to have only minimal overlap */
-      if (snap_data->major_snap_distance == G_MAXUINT)
-        {
-          /* Hanging over the left/right edge on the top */
-          maybe_update_snap (snap_data, x1, y1, _x1 - w + MIN_OVERLAP, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 1);
-          maybe_update_snap (snap_data, x1, y1, _x2 - MIN_OVERLAP, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, -1);
+      maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y1 - h + MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, 1);
+      maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y2 - MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, -1);
+    }
 
-          /* Left/right edge identical on the bottom */
-          maybe_update_snap (snap_data, x1, y1, _x1 - w + MIN_OVERLAP, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 1);
-          maybe_update_snap (snap_data, x1, y1, _x2 - MIN_OVERLAP, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, -1);
+#undef OVERLAP
+}
 
-          /* Top/bottom edge identical on the left */
-          maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y1 - h + MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, 1);
-          maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y2 - MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, -1);
+static void
+find_best_snapping (CcDisplayConfig   *config,
+                    CcDisplayMonitor  *snap_output,
+                    SnapIndex         *index,
+                    SnapData          *snap_data)
+{
+  SnapIndex *own_index = NULL;
+  gint x1, y1, x2, y2;
+  gint w, h;
+  gdouble range_x, range_y;
+  guint i;
 
-          /* Top/bottom edge identical on the right */
-          maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y1 - h + MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, 1);
-          maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y2 - MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, -1);
-        }
+  g_assert (snap_data != NULL);
+
+  if (index == NULL)
+    index = own_index = snap_index_new (config, snap_output);
+
+  get_scaled_geometry (config, snap_output, &x1, &y1, &w, &h);
+  x2 = x1 + w;
+  y2 = y1 + h;
+
+  /* Every snap needs the distance on its major axis to be within the major
+   * snap distance. So unless that is unlimited, only monitors with an edge
+   * close to the matching edge of the snapped monitor can be snapped to. */
+  range_x = snap_data->major_snap_distance / fabs (snap_data->to_widget.xx) + 1;
+  range_y = snap_data->major_snap_distance / fabs (snap_data->to_widget.yy) + 1;
+
+  if (snap_data->major_snap_distance == G_MAXUINT || !isfinite (range_x) || !isfinite (range_y))
+    {
+      for (i = 0; i < index->candidates->len; i++)
+        g_array_index (index->candidates, gboolean, i) = TRUE;
     }
+  else
+    {
+      for (i = 0; i < index->candidates->len; i++)
+        g_array_index (index->candidates, gboolean, i) = FALSE;
 
-#undef OVERLAP
+      /* Snapping to the left/right side, left_snap_pos/right_snap_pos */
+      snap_index_mark_edges (index, EDGE_LEFT, x2 - range_x, x2 + range_x);
+      snap_index_mark_edges (index, EDGE_RIGHT, x1 - range_x, x1 + range_x);
+
+      /* Snapping above/below, top_snap_pos/bottom_snap_pos */
+      snap_index_mark_edges (index, EDGE_TOP, y2 - range_y, y2 + range_y);
+      snap_index_mark_edges (index, EDGE_BOTTOM, y1 - range_y, y1 + range_y);
+    }
+
+  /* Walk in monitor order, as ties are resolved by the first match */
+  for (i = 0; i < index->rects->len; i++)
+    {
+      if (!g_array_index (index->candidates, gboolean, i))
+        continue;
+
+      snap_to_rect (snap_data, x1, y1, x2, y2, &g_array_index (index->rects, SnapRect, i));
+    }
+
+  g_clear_pointer (&own_index, snap_index_free);
 }
 
 static void
@@ -447,9 +629,16 @@ cc_display_arrangement_update_matrices (CcDisplayArrangement *self)
   if (self->drag_active)
     return;
 
-  get_bounding_box (self->config, &x1, &y1, &x2, &y2, &max_w, &max_h);
   gtk_widget_get_allocation (GTK_WIDGET (self), &allocation);
 
+  /* Only recompute after the monitors or the allocation changed */
+  if (self->matrices_valid &&
+      self->matrices_width == allocation.width &&
+      self->matrices_height == allocation.height)
+    return;
+
+  get_bounding_box (self->config, &x1, &y1, &x2, &y2, &max_w, &max_h);
+
   scale_h = (gdouble) (allocation.width - 2 * MARGIN_PX) / (x2 - x1 + max_w * 2 * MARGIN_MON);
   scale_w = (gdouble) (allocation.height - 2 * MARGIN_PX) / (y2 - y1 + max_h * 2 * MARGIN_MON);
 
@@ -462,6 +651,10 @@ cc_display_arrangement_update_matrices (CcDisplayArrangement *self)
 
   self->to_actual = self->to_widget;
   cairo_matrix_invert (&self->to_actual);
+
+  self->matrices_valid = TRUE;
+  self->matrices_width = allocation.width;
+  self->matrices_height = allocation.height;
 }
 
 static CcDisplayMonitor*
@@ -521,6 +714,12 @@ on_output_changed_cb (CcDisplayArrangement *self,
   else
     self->major_snap_distance = G_MAXUINT;
 
+  self->matrices_valid = FALSE;
+
+  /* Only the dragged monitor may move without invalidating the snap index */
+  if (output != self->selected_output)
+    g_clear_pointer (&self->snap_index, snap_index_free);
+
   gtk_widget_queue_draw (GTK_WIDGET (self));
 }
 
@@ -714,6 +913,7 @@ cc_display_arrangement_button_release_event (GtkWidget      *widget,
     return FALSE;
 
   self->drag_active = FALSE;
+  g_clear_pointer (&self->snap_index, snap_index_free);
 
   output = cc_display_arrangement_find_monitor_at (self, event->x, event->y);
   cc_display_arrangement_update_cursor (self, output != NULL);
@@ -776,7 +976,10 @@ cc_display_arrangement_motion_notify_event (GtkWidget      *widget,
 
   cc_display_monitor_set_position (self->selected_output, mon_x, mon_y);
 
-  find_best_snapping (self->config, self->selected_output, &snap_data);
+  if (self->snap_index == NULL)
+    self->snap_index = snap_index_new (self->config, self->selected_output);
+
+  find_best_snapping (self->config, self->selected_output, self->snap_index, &snap_data);
 
   cc_display_monitor_set_position (self->selected_output, snap_data.mon_x, snap_data.mon_y);
 
@@ -834,6 +1037,7 @@ cc_display_arrangement_finalize (GObject *object)
 {
   CcDisplayArrangement *self = CC_DISPLAY_ARRANGEMENT (object);
 
+  g_clear_pointer (&self->snap_index, snap_index_free);
   g_clear_object (&self->config);
 
   G_OBJECT_CLASS (cc_display_arrangement_parent_class)->finalize (object);
@@ -918,6 +1122,8 @@ cc_display_arrangement_set_config (CcDisplayArrangement *self,
   g_clear_object (&self->config);
 
   self->drag_active = FALSE;
+  self->matrices_valid = FALSE;
+  g_clear_pointer (&self->snap_index, snap_index_free);
 
   /* Listen to all the signals */
   if (config)
@@ -982,7 +1188,7 @@ cc_display_config_snap_output (CcDisplayConfig  *config,
   cairo_matrix_init_identity (&snap_data.to_widget);
   snap_data.major_snap_distance = G_MAXUINT;
 
-  find_best_snapping (config, output, &snap_data);
+  find_best_snapping (config, output, NULL, &snap_data);
 
   cc_display_monitor_set_position (output, snap_data.mon_x, snap_data.mon_y);
 }
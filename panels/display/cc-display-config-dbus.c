@@ -46,13 +46,18 @@ struct _CcDisplayModeDBus
 {
   CcDisplayMode parent_instance;
 
-  char *id;
+  /* A child of the GetCurrentState reply, sharing its memory. Only the
+   * fields needed to list and compare modes are unpacked up front. */
+  GVariant *variant;
+
   int width;
   int height;
   double refresh_rate;
+  guint32 flags;
+
+  /* Unpacked on first use */
   double preferred_scale;
   GArray *supported_scales;
-  guint32 flags;
 };
 
 G_DEFINE_TYPE (CcDisplayModeDBus,
@@ -74,6 +79,34 @@ cc_display_mode_dbus_equal (const CcDisplayModeDBus *m1,
     (m1->flags & MODE_INTERLACED) == (m2->flags & MODE_INTERLACED);
 }
 
+static void
+cc_display_mode_dbus_ensure_scales (CcDisplayModeDBus *self)
+{
+  g_autoptr(GVariant) scales = NULL;
+  const double *data;
+  gsize n_scales;
+
+  if (self->supported_scales)
+    return;
+
+  g_variant_get_child (self->variant, 4, "d", &self->preferred_scale);
+
+  scales = g_variant_get_child_value (self->variant, 5);
+  data = g_variant_get_fixed_array (scales, &n_scales, sizeof (double));
+  self->supported_scales = g_array_sized_new (TRUE, TRUE, sizeof (double), n_scales);
+  g_array_append_vals (self->supported_scales, data, n_scales);
+}
+
+static const char *
+cc_display_mode_dbus_get_id (CcDisplayModeDBus *self)
+{
+  const char *id;
+
+  g_variant_get_child (self->variant, 0, "&s", &id);
+
+  return id;
+}
+
 static void
 cc_display_mode_dbus_get_resolution (CcDisplayMode *pself,
                                      int *w, int *h)
@@ -91,6 +124,8 @@ cc_display_mode_dbus_get_supported_scales (CcDisplayMode *pself)
 {
   CcDisplayModeDBus *self = CC_DISPLAY_MODE_DBUS (pself);
 
+  cc_display_mode_dbus_ensure_scales (self);
+
   return (const double *) self->supported_scales->data;
 }
 
@@ -99,6 +134,8 @@ cc_display_mode_dbus_get_preferred_scale (CcDisplayMode *pself)
 {
   CcDisplayModeDBus *self = CC_DISPLAY_MODE_DBUS (pself);
 
+  cc_display_mode_dbus_ensure_scales (self);
+
   return self->preferred_scale;
 }
 
@@ -109,6 +146,7 @@ cc_display_mode_dbus_is_supported_scale (CcDisplayMode *pself,
   CcDisplayModeDBus *self = CC_DISPLAY_MODE_DBUS (pself);
 
   guint i;
+  cc_display_mode_dbus_ensure_scales (self);
   for (i = 0; i < self->supported_scales->len; i++)
     if (g_array_index (self->supported_scales, double, i) == scale)
       return TRUE;
@@ -143,7 +181,6 @@ cc_display_mode_dbus_get_freq_f (CcDisplayMode *pself)
 static void
 cc_display_mode_dbus_init (CcDisplayModeDBus *self)
 {
-  self->supported_scales = g_array_new (TRUE, TRUE, sizeof (double));
 }
 
 static void
@@ -151,8 +188,9 @@ cc_display_mode_dbus_finalize (GObject *object)
 {
   CcDisplayModeDBus *self = CC_DISPLAY_MODE_DBUS (object);
 
-  g_free (self->id);
-  g_array_free (self->supported_scales, TRUE);
+  g_clear_pointer (&self->variant, g_variant_unref);
+  if (self->supported_scales)
+    g_array_free (self->supported_scales, TRUE);
 
   G_OBJECT_CLASS (cc_display_mode_dbus_parent_class)->finalize (object);
 }
@@ -176,25 +214,18 @@ cc_display_mode_dbus_class_init (CcDisplayModeDBusClass *klass)
 static CcDisplayModeDBus *
 cc_display_mode_dbus_new (GVariant *variant)
 {
-  double d;
-  g_autoptr(GVariantIter) scales_iter = NULL;
   g_autoptr(GVariant) properties_variant = NULL;
   gboolean is_current;
   gboolean is_preferred;
   gboolean is_interlaced;
   CcDisplayModeDBus *self = g_object_new (CC_TYPE_DISPLAY_MODE_DBUS, NULL);
 
-  g_variant_get (variant, "(" MODE_BASE_FORMAT "@a{sv})",
-                 &self->id,
-                 &self->width,
-                 &self->height,
-                 &self->refresh_rate,
-                 &self->preferred_scale,
-                 &scales_iter,
-                 &properties_variant);
+  self->variant = g_variant_ref (variant);
 
-  while (g_variant_iter_next (scales_iter, "d", &d))
-    g_array_append_val (self->supported_scales, d);
+  g_variant_get_child (variant, 1, "i", &self->width);
+  g_variant_get_child (variant, 2, "i", &self->height);
+  g_variant_get_child (variant, 3, "d", &self->refresh_rate);
+  properties_variant = g_variant_get_child_value (variant, 6);
 
   if (!g_variant_lookup (properties_variant, "is-current", "b", &is_current))
     is_current = FALSE;
@@ -304,12 +335,34 @@ struct _CcDisplayMonitorDBus
   int max_height;
 
   GList *modes;
+  GHashTable *modes_by_resolution;
   CcDisplayMode *current_mode;
   CcDisplayMode *preferred_mode;
 
   CcDisplayLogicalMonitor *logical_monitor;
 };
 
+/* All modes of a monitor sharing one resolution, in the order of the mode list */
+typedef struct
+{
+  GPtrArray *modes;
+  CcDisplayModeDBus *highest_rate;
+} CcDisplayModeBucket;
+
+static gpointer
+resolution_key (int width,
+                int height)
+{
+  return GUINT_TO_POINTER (((guint) width & 0xffff) << 16 | ((guint) height & 0xffff));
+}
+
+static void
+cc_display_mode_bucket_free (CcDisplayModeBucket *bucket)
+{
+  g_ptr_array_unref (bucket->modes);
+  g_free (bucket);
+}
+
 G_DEFINE_TYPE (CcDisplayMonitorDBus,
                cc_display_monitor_dbus,
                CC_TYPE_DISPLAY_MONITOR)
@@ -330,6 +383,8 @@ cc_display_config_dbus_append_right (CcDisplayConfigDBus *self,
                                      CcDisplayLogicalMonitor *monitor);
 static void
 cc_display_config_dbus_make_linear (CcDisplayConfigDBus *self);
+static void
+cc_display_config_dbus_mark_modified (CcDisplayConfigDBus *self);
 
 
 static const char *
@@ -594,6 +649,8 @@ cc_display_monitor_dbus_set_underscanning (CcDisplayMonitor *pself,
   if (self->underscanning == UNDERSCANNING_UNSUPPORTED)
     return;
 
+  cc_display_config_dbus_mark_modified (self->config);
+
   if (underscanning)
     self->underscanning = UNDERSCANNING_ENABLED;
   else
@@ -604,33 +661,25 @@ static CcDisplayMode *
 cc_display_monitor_dbus_get_closest_mode (CcDisplayMonitorDBus *self,
                                           CcDisplayModeDBus *mode)
 {
-  CcDisplayModeDBus *best = NULL;
-  GList *l;
+  CcDisplayModeBucket *bucket;
+  guint i;
 
-  for (l = self->modes; l != NULL; l = l->next)
-    {
-      CcDisplayModeDBus *similar = l->data;
+  bucket = g_hash_table_lookup (self->modes_by_resolution,
+                                resolution_key (mode->width, mode->height));
+  if (!bucket)
+    return NULL;
 
-      if (similar->width != mode->width ||
-          similar->height != mode->height)
-        continue;
+  for (i = 0; i < bucket->modes->len; i++)
+    {
+      CcDisplayModeDBus *similar = g_ptr_array_index (bucket->modes, i);
 
       if (similar->refresh_rate == mode->refresh_rate &&
           (similar->flags & MODE_INTERLACED) == (mode->flags & MODE_INTERLACED))
-        {
-          best = similar;
-          break;
-        }
-
-      /* There might be a better heuristic. */
-      if (!best || best->refresh_rate < similar->refresh_rate)
-        {
-          best = similar;
-          continue;
-        }
+        return CC_DISPLAY_MODE (similar);
     }
 
-  return CC_DISPLAY_MODE (best);
+  /* There might be a better heuristic. */
+  return CC_DISPLAY_MODE (bucket->highest_rate);
 }
 
 static void
@@ -714,6 +763,8 @@ cc_display_monitor_dbus_init (CcDisplayMonitorDBus *self)
   self->underscanning = UNDERSCANNING_UNSUPPORTED;
   self->max_width = G_MAXINT;
   self->max_height = G_MAXINT;
+  self->modes_by_resolution = g_hash_table_new_full (NULL, NULL, NULL,
+                                                     (GDestroyNotify) cc_display_mode_bucket_free);
 }
 
 static void
@@ -727,6 +778,7 @@ cc_display_monitor_dbus_finalize (GObject *object)
   g_free (self->product_serial);
   g_free (self->display_name);
 
+  g_clear_pointer (&self->modes_by_resolution, g_hash_table_destroy);
   g_list_foreach (self->modes, (GFunc) g_object_unref, NULL);
   g_clear_pointer (&self->modes, g_list_free);
 
@@ -777,6 +829,7 @@ construct_modes (CcDisplayMonitorDBus *self,
                  GVariantIter *modes)
 {
   CcDisplayModeDBus *mode;
+  GList *l;
 
   while (TRUE)
     {
@@ -793,6 +846,29 @@ construct_modes (CcDisplayMonitorDBus *self,
       if (mode->flags & MODE_CURRENT)
         self->current_mode = CC_DISPLAY_MODE (mode);
     }
+
+  /* Bucket the modes by resolution, so that finding the closest mode for
+   * cloning or mode switches does not need to walk all of them. */
+  for (l = self->modes; l != NULL; l = l->next)
+    {
+      CcDisplayModeBucket *bucket;
+      gpointer key;
+
+      mode = l->data;
+      key = resolution_key (mode->width, mode->height);
+
+      bucket = g_hash_table_lookup (self->modes_by_resolution, key);
+      if (!bucket)
+        {
+          bucket = g_new0 (CcDisplayModeBucket, 1);
+          bucket->modes = g_ptr_array_new ();
+          g_hash_table_insert (self->modes_by_resolution, key, bucket);
+        }
+
+      g_ptr_array_add (bucket->modes, mode);
+      if (!bucket->highest_rate || bucket->highest_rate->refresh_rate < mode->refresh_rate)
+        bucket->highest_rate = mode;
+    }
 }
 
 static CcDisplayMonitorDBus *
@@ -876,6 +952,8 @@ struct _CcDisplayConfigDBus
   CcDisplayConfig parent_instance;
 
   GVariant *state;
+  guint state_hash;
+  gboolean modified;
   GDBusConnection *connection;
   GDBusProxy *proxy;
 
@@ -943,7 +1021,7 @@ build_monitors_variant (GHashTable *monitors)
       mode_dbus = CC_DISPLAY_MODE_DBUS (monitor->current_mode);
       g_variant_builder_add (&builder, "(ss@*)",
                              monitor->connector_name,
-                             mode_dbus->id,
+                             cc_display_mode_dbus_get_id (mode_dbus),
                              g_variant_builder_end (&props_builder));
     }
 
@@ -1057,6 +1135,12 @@ cc_display_config_dbus_equal (CcDisplayConfig *pself,
   g_return_val_if_fail (pself, FALSE);
   g_return_val_if_fail (pother, FALSE);
 
+  /* Untouched configurations built from the same state are equal */
+  if (!self->modified && !other->modified &&
+      self->state_hash == other->state_hash &&
+      g_variant_equal (self->state, other->state))
+    return TRUE;
+
   cc_display_config_dbus_ensure_non_offset_coords (self);
   cc_display_config_dbus_ensure_non_offset_coords (other);
 
@@ -1159,6 +1243,8 @@ cc_display_config_dbus_set_cloning (CcDisplayConfig *pself,
   CcDisplayLogicalMonitor *logical_monitor;
   GList *l;
 
+  self->modified = TRUE;
+
   if (clone && !is_cloning)
     {
       logical_monitor = g_object_new (CC_TYPE_DISPLAY_LOGICAL_MONITOR, NULL);
@@ -1231,15 +1317,14 @@ is_scale_allowed_by_active_monitors (CcDisplayConfigDBus *self,
 {
   GList *l;
 
+  /* The check does not depend on the monitor, so one active monitor is
+   * enough to know the answer. */
   for (l = self->monitors; l != NULL; l = l->next)
     {
       CcDisplayMonitorDBus *m = CC_DISPLAY_MONITOR_DBUS (l->data);
 
-      if (!cc_display_monitor_is_active (CC_DISPLAY_MONITOR (m)))
-        continue;
-
-      if (!is_scaled_mode_allowed (self, mode, scale))
-        return FALSE;
+      if (cc_display_monitor_is_active (CC_DISPLAY_MONITOR (m)))
+        return is_scaled_mode_allowed (self, mode, scale);
     }
 
   return TRUE;
@@ -1309,7 +1394,10 @@ gather_clone_modes (CcDisplayConfigDBus *self)
       for (ll = self->monitors->next; ll != NULL; ll = ll->next)
         {
           CcDisplayMonitorDBus *other_monitor = ll->data;
-          if (!cc_display_monitor_dbus_get_closest_mode (other_monitor, mode))
+
+          /* A constant time lookup of the resolution bucket */
+          if (!g_hash_table_contains (other_monitor->modes_by_resolution,
+                                      resolution_key (mode->width, mode->height)))
             {
               valid = FALSE;
               break;
@@ -1468,6 +1556,22 @@ proxy_properties_changed_cb (GDBusProxy          *proxy,
     update_panel_orientation_managed (self);
 }
 
+static guint
+hash_state (GVariant *state)
+{
+  g_autoptr(GBytes) bytes = NULL;
+
+  bytes = g_variant_get_data_as_bytes (state);
+
+  return g_bytes_hash (bytes);
+}
+
+static void
+cc_display_config_dbus_mark_modified (CcDisplayConfigDBus *self)
+{
+  self->modified = TRUE;
+}
+
 static void
 cc_display_config_dbus_constructed (GObject *object)
 {
@@ -1476,6 +1580,7 @@ cc_display_config_dbus_constructed (GObject *object)
   g_autoptr(GVariantIter) logical_monitors = NULL;
   g_autoptr(GVariantIter) props = NULL;
   g_autoptr(GError) error = NULL;
+  GList *l;
 
   g_variant_get (self->state,
                  CURRENT_STATE_FORMAT,
@@ -1516,6 +1621,17 @@ cc_display_config_dbus_constructed (GObject *object)
 
   construct_monitors (self, monitors, logical_monitors);
 
+  /* Track whether the configuration still matches the state */
+  self->state_hash = hash_state (self->state);
+  for (l = self->monitors; l != NULL; l = l->next)
+    {
+      const gchar *signals[] = { "rotation", "mode", "primary", "active", "scale", "position-changed", "is-usable" };
+      guint i;
+
+      for (i = 0; i < G_N_ELEMENTS (signals); i++)
+        g_signal_connect_swapped (l->data, signals[i], G_CALLBACK (cc_display_config_dbus_mark_modified), self);
+    }
+
   self->proxy = g_dbus_proxy_new_sync (self->connection,
                                        G_DBUS_PROXY_FLAGS_NONE,
                                        NULL,
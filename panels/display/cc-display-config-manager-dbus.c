@@ -74,6 +74,15 @@ got_current_state (GObject      *object,
     }
 
   self = CC_DISPLAY_CONFIG_MANAGER_DBUS (data);
+
+  /* The state includes a serial, so an identical reply means nothing
+   * changed and the configuration does not need to be rebuilt. */
+  if (self->current_state && g_variant_equal (self->current_state, variant))
+    {
+      g_variant_unref (variant);
+      return;
+    }
+
   g_clear_pointer (&self->current_state, g_variant_unref);
   self->current_state = variant;
 
@@ -33,7 +33,7 @@ struct _CcDisplaySettings
   GtkDrawingArea    object;
 
   gboolean          updating;
-  guint             idle_udpate_id;
+  guint             rebuild_tick_id;
 
   gboolean          has_accelerometer;
   CcDisplayConfig  *config;
@@ -43,6 +43,10 @@ struct _CcDisplaySettings
   GListStore       *refresh_rate_list;
   GListStore       *resolution_list;
 
+  /* CcDisplayMonitor → MonitorModes, valid as long as the config is */
+  GHashTable       *monitor_modes;
+  GPtrArray        *sorted_clone_modes;
+
   GtkWidget        *orientation_row;
   GtkWidget        *refresh_rate_row;
   GtkWidget        *resolution_row;
@@ -54,6 +58,14 @@ struct _CcDisplaySettings
 
 typedef struct _CcDisplaySettings CcDisplaySettings;
 
+/* The modes of a monitor sorted for the resolution and refresh rate lists,
+ * which only needs to happen once per configuration. */
+typedef struct
+{
+  GPtrArray  *by_resolution;   /* largest resolution first, stable */
+  GHashTable *by_freq;         /* "WxH" → GPtrArray, highest rate first */
+} MonitorModes;
+
 enum {
   PROP_0,
   PROP_HAS_ACCELEROMETER,
@@ -223,18 +235,172 @@ sort_modes_by_freq_desc (CcDisplayMode *a, CcDisplayMode *b)
   return delta;
 }
 
+static gint
+sort_mode_ptrs_by_area_desc (gconstpointer a, gconstpointer b)
+{
+  return sort_modes_by_area_desc (*(CcDisplayMode **) a, *(CcDisplayMode **) b);
+}
+
+static gint
+sort_mode_ptrs_by_freq_desc (gconstpointer a, gconstpointer b)
+{
+  return sort_modes_by_freq_desc (*(CcDisplayMode **) a, *(CcDisplayMode **) b);
+}
+
+/* g_ptr_array_sort() is stable, so modes of the same resolution keep the
+ * order of the list */
+static GPtrArray *
+sort_modes (GList        *modes,
+            GCompareFunc  compare_func)
+{
+  GPtrArray *sorted;
+  GList *l;
+
+  sorted = g_ptr_array_new ();
+  for (l = modes; l != NULL; l = l->next)
+    g_ptr_array_add (sorted, l->data);
+  g_ptr_array_sort (sorted, compare_func);
+
+  return sorted;
+}
+
+static void
+monitor_modes_free (MonitorModes *monitor_modes)
+{
+  g_ptr_array_unref (monitor_modes->by_resolution);
+  g_hash_table_unref (monitor_modes->by_freq);
+  g_free (monitor_modes);
+}
+
+static MonitorModes *
+get_monitor_modes (CcDisplaySettings *self,
+                   CcDisplayMonitor  *output)
+{
+  MonitorModes *monitor_modes;
+
+  monitor_modes = g_hash_table_lookup (self->monitor_modes, output);
+  if (monitor_modes)
+    return monitor_modes;
+
+  monitor_modes = g_new0 (MonitorModes, 1);
+  monitor_modes->by_resolution = sort_modes (cc_display_monitor_get_modes (output),
+                                             sort_mode_ptrs_by_area_desc);
+  monitor_modes->by_freq = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                  g_free, (GDestroyNotify) g_ptr_array_unref);
+  g_hash_table_insert (self->monitor_modes, output, monitor_modes);
+
+  return monitor_modes;
+}
+
+/* All modes of @output with the given resolution, highest refresh rate first */
+static GPtrArray *
+get_modes_for_resolution (CcDisplaySettings *self,
+                          CcDisplayMonitor  *output,
+                          gint               width,
+                          gint               height)
+{
+  MonitorModes *monitor_modes;
+  g_autofree gchar *key = NULL;
+  GList *modes = NULL;
+  GList *l;
+  GPtrArray *sorted;
+
+  monitor_modes = get_monitor_modes (self, output);
+
+  key = g_strdup_printf ("%dx%d", width, height);
+  sorted = g_hash_table_lookup (monitor_modes->by_freq, key);
+  if (sorted)
+    return sorted;
+
+  for (l = cc_display_monitor_get_modes (output); l != NULL; l = l->next)
+    {
+      gint w, h;
+
+      cc_display_mode_get_resolution (CC_DISPLAY_MODE (l->data), &w, &h);
+      if (w == width && h == height)
+        modes = g_list_prepend (modes, l->data);
+    }
+  modes = g_list_reverse (modes);
+
+  sorted = sort_modes (modes, sort_mode_ptrs_by_freq_desc);
+  g_list_free (modes);
+  g_hash_table_insert (monitor_modes->by_freq, g_steal_pointer (&key), sorted);
+
+  return sorted;
+}
+
 static gboolean
+scale_buttons_match (GList  *buttons,
+                     GArray *scales)
+{
+  GList *l;
+  guint i;
+
+  if (g_list_length (buttons) != scales->len)
+    return FALSE;
+
+  for (l = buttons, i = 0; l != NULL; l = l->next, i++)
+    if (*(gdouble*) g_object_get_data (G_OBJECT (l->data), "scale") != g_array_index (scales, gdouble, i))
+      return FALSE;
+
+  return TRUE;
+}
+
+static void
+clear_mode_caches (CcDisplaySettings *self)
+{
+  g_hash_table_remove_all (self->monitor_modes);
+  g_clear_pointer (&self->sorted_clone_modes, g_ptr_array_unref);
+}
+
+/* Only touches the store if its content differs, and then replaces it
+ * with a single items-changed emission. */
+static void
+update_mode_list (GListStore *store,
+                  GPtrArray  *modes)
+{
+  GListModel *model = G_LIST_MODEL (store);
+  guint n_items;
+  guint i;
+
+  n_items = g_list_model_get_n_items (model);
+  if (n_items == modes->len)
+    {
+      for (i = 0; i < n_items; i++)
+        {
+          g_autoptr(GObject) item = g_list_model_get_item (model, i);
+
+          if (item != g_ptr_array_index (modes, i))
+            break;
+        }
+
+      if (i == n_items)
+        return;
+    }
+
+  g_list_store_splice (store, 0, n_items, modes->pdata, modes->len);
+}
+
+static void
 cc_display_settings_rebuild_ui (CcDisplaySettings *self)
 {
   GList *modes;
-  GList *item;
+  GPtrArray *sorted_modes;
+  g_autoptr(GPtrArray) resolution_modes = NULL;
+  g_autoptr(GArray) shown_scales = NULL;
+  g_autoptr(GList) scale_buttons = NULL;
   gint width, height;
   CcDisplayMode *current_mode;
+  gboolean has_current = FALSE;
   GtkRadioButton *group = NULL;
-  gint buttons = 0;
   const gdouble *scales, *scale;
+  guint i;
 
-  self->idle_udpate_id = 0;
+  if (self->rebuild_tick_id)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->rebuild_tick_id);
+      self->rebuild_tick_id = 0;
+    }
 
   if (!self->config || !self->selected_output)
     {
@@ -244,7 +410,7 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
       gtk_widget_set_visible (self->scale_row, FALSE);
       gtk_widget_set_visible (self->underscanning_row, FALSE);
 
-      return G_SOURCE_REMOVE;
+      return;
     }
 
   g_object_freeze_notify ((GObject*) self->orientation_row);
@@ -267,30 +433,46 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
 
   if (should_show_rotation (self))
     {
-      guint i;
       CcDisplayRotation rotations[] = { CC_DISPLAY_ROTATION_NONE,
                                         CC_DISPLAY_ROTATION_90,
                                         CC_DISPLAY_ROTATION_270,
                                         CC_DISPLAY_ROTATION_180 };
+      CcDisplayRotation supported[G_N_ELEMENTS (rotations)];
+      guint n_supported = 0;
+      gboolean unchanged;
 
       gtk_widget_set_visible (self->orientation_row, TRUE);
 
-      g_list_store_remove_all (self->orientation_list);
       for (i = 0; i < G_N_ELEMENTS (rotations); i++)
+        if (cc_display_monitor_supports_rotation (self->selected_output, rotations[i]))
+          supported[n_supported++] = rotations[i];
+
+      /* Keep the existing items if the same rotations are supported */
+      unchanged = g_list_model_get_n_items (G_LIST_MODEL (self->orientation_list)) == n_supported;
+      for (i = 0; unchanged && i < n_supported; i++)
         {
           g_autoptr(HdyValueObject) obj = NULL;
 
-          if (!cc_display_monitor_supports_rotation (self->selected_output, rotations[i]))
-            continue;
+          obj = g_list_model_get_item (G_LIST_MODEL (self->orientation_list), i);
+          unchanged = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (obj), "rotation-value")) == supported[i];
+        }
 
-          obj = hdy_value_object_new_collect (G_TYPE_STRING, string_for_rotation (rotations[i]));
-          g_list_store_append (self->orientation_list, obj);
-          g_object_set_data (G_OBJECT (obj), "rotation-value", GINT_TO_POINTER (rotations[i]));
+      if (!unchanged)
+        {
+          g_list_store_remove_all (self->orientation_list);
+          for (i = 0; i < n_supported; i++)
+            {
+              g_autoptr(HdyValueObject) obj = NULL;
 
-          if (cc_display_monitor_get_rotation (self->selected_output) == rotations[i])
-            hdy_combo_row_set_selected_index (HDY_COMBO_ROW (self->orientation_row),
-                                              g_list_model_get_n_items (G_LIST_MODEL (self->orientation_list)) - 1);
+              obj = hdy_value_object_new_collect (G_TYPE_STRING, string_for_rotation (supported[i]));
+              g_object_set_data (G_OBJECT (obj), "rotation-value", GINT_TO_POINTER (supported[i]));
+              g_list_store_append (self->orientation_list, obj);
+            }
         }
+
+      for (i = 0; i < n_supported; i++)
+        if (cc_display_monitor_get_rotation (self->selected_output) == supported[i])
+          hdy_combo_row_set_selected_index (HDY_COMBO_ROW (self->orientation_row), i);
     }
   else
     {
@@ -300,35 +482,22 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
   /* Only show refresh rate if we are not in cloning mode. */
   if (!cc_display_config_is_cloning (self->config))
     {
-      GList *item;
       gdouble freq;
+      gint selected = -1;
 
       freq = cc_display_mode_get_freq_f (current_mode);
 
-      modes = cc_display_monitor_get_modes (self->selected_output);
-
-      g_list_store_remove_all (self->refresh_rate_list);
+      /* At some point we used to filter very close resolutions,
+       * but we don't anymore these days.
+       */
+      sorted_modes = get_modes_for_resolution (self, self->selected_output, width, height);
+      update_mode_list (self->refresh_rate_list, sorted_modes);
 
-      for (item = modes; item != NULL; item = item->next)
-        {
-          gint w, h;
-          guint new;
-          CcDisplayMode *mode = CC_DISPLAY_MODE (item->data);
-
-          cc_display_mode_get_resolution (mode, &w, &h);
-          if (w != width || h != height)
-            continue;
-
-          /* At some point we used to filter very close resolutions,
-           * but we don't anymore these days.
-           */
-          new = g_list_store_insert_sorted (self->refresh_rate_list,
-                                            mode,
-                                            (GCompareDataFunc) sort_modes_by_freq_desc,
-                                            NULL);
-          if (freq == cc_display_mode_get_freq_f (mode))
-            hdy_combo_row_set_selected_index (HDY_COMBO_ROW (self->refresh_rate_row), new);
-        }
+      for (i = 0; i < sorted_modes->len; i++)
+        if (freq == cc_display_mode_get_freq_f (g_ptr_array_index (sorted_modes, i)))
+          selected = i;
+      if (selected >= 0)
+        hdy_combo_row_set_selected_index (HDY_COMBO_ROW (self->refresh_rate_row), selected);
 
       /* Show if we have more than one frequency to choose from. */
       gtk_widget_set_visible (self->refresh_rate_row,
@@ -343,91 +512,122 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
   /* Resolutions are always shown. */
   gtk_widget_set_visible (self->resolution_row, TRUE);
   if (cc_display_config_is_cloning (self->config))
-    modes = cc_display_config_get_cloning_modes (self->config);
+    {
+      if (!self->sorted_clone_modes)
+        self->sorted_clone_modes = sort_modes (cc_display_config_get_cloning_modes (self->config),
+                                               sort_mode_ptrs_by_area_desc);
+      sorted_modes = self->sorted_clone_modes;
+    }
   else
-    modes = cc_display_monitor_get_modes (self->selected_output);
+    {
+      sorted_modes = get_monitor_modes (self, self->selected_output)->by_resolution;
+    }
 
-  g_list_store_remove_all (self->resolution_list);
-  g_list_store_append (self->resolution_list, current_mode);
-  hdy_combo_row_set_selected_index (HDY_COMBO_ROW (self->resolution_row), 0);
-  for (item = modes; item != NULL; item = item->next)
+  /* One mode per resolution: the current one, or else the first usable one */
+  resolution_modes = g_ptr_array_new ();
+  for (i = 0; i < sorted_modes->len; i++)
     {
-      gint ins;
-      gint w, h;
-      CcDisplayMode *mode = CC_DISPLAY_MODE (item->data);
+      CcDisplayMode *mode = g_ptr_array_index (sorted_modes, i);
+      CcDisplayMode *last = NULL;
 
-      /* Exclude unusable low resolutions */
-      if (!cc_display_config_is_scaled_mode_valid (self->config, mode, 1.0))
+      if (resolution_modes->len > 0)
+        last = g_ptr_array_index (resolution_modes, resolution_modes->len - 1);
+      if (last && sort_modes_by_area_desc (mode, last) == 0)
         continue;
 
-      cc_display_mode_get_resolution (mode, &w, &h);
-
-      /* Find the appropriate insertion point. */
-      for (ins = 0; ins < g_list_model_get_n_items (G_LIST_MODEL (self->resolution_list)); ins++)
+      if (sort_modes_by_area_desc (mode, current_mode) == 0)
         {
-          g_autoptr(CcDisplayMode) m = NULL;
-          gint cmp;
-
-          m = g_list_model_get_item (G_LIST_MODEL (self->resolution_list), ins);
-
-          cmp = sort_modes_by_area_desc (mode, m);
-          /* Next item is smaller, insert at this point. */
-          if (cmp < 0)
-            break;
-
-          /* Don't insert if it is already in the list */
-          if (cmp == 0)
-            {
-              ins = -1;
-              break;
-            }
+          mode = current_mode;
+          has_current = TRUE;
+        }
+      /* Exclude unusable low resolutions */
+      else if (!cc_display_config_is_scaled_mode_valid (self->config, mode, 1.0))
+        {
+          continue;
+        }
+      else if (!has_current && sort_modes_by_area_desc (mode, current_mode) > 0)
+        {
+          /* The current mode is always listed, even if it is not in the list */
+          g_ptr_array_add (resolution_modes, current_mode);
+          has_current = TRUE;
         }
 
-        if (ins >= 0)
-          g_list_store_insert (self->resolution_list, ins, mode);
+      g_ptr_array_add (resolution_modes, mode);
     }
+  if (!has_current)
+    g_ptr_array_add (resolution_modes, current_mode);
+
+  update_mode_list (self->resolution_list, resolution_modes);
+  for (i = 0; i < resolution_modes->len; i++)
+    if (g_ptr_array_index (resolution_modes, i) == current_mode)
+      hdy_combo_row_set_selected_index (HDY_COMBO_ROW (self->resolution_row), i);
 
 
   /* Scale row is usually shown. */
-  gtk_container_foreach (GTK_CONTAINER (self->scale_bbox), (GtkCallback) gtk_widget_destroy, NULL);
+  shown_scales = g_array_new (FALSE, FALSE, sizeof (gdouble));
   scales = cc_display_mode_get_supported_scales (current_mode);
-  for (scale = scales; *scale != 0.0; scale++)
+  for (scale = scales; *scale != 0.0 && shown_scales->len < MAX_SCALE_BUTTONS; scale++)
     {
-      g_autofree gchar *scale_str = NULL;
-      GtkWidget *scale_btn;
-
       if (!cc_display_config_is_scaled_mode_valid (self->config,
                                                    current_mode,
                                                    *scale) &&
           cc_display_monitor_get_scale (self->selected_output) != *scale)
         continue;
 
-      scale_str = make_scale_string (*scale);
-
-      scale_btn = gtk_radio_button_new_with_label_from_widget (group, scale_str);
-      if (!group)
-        group = GTK_RADIO_BUTTON (scale_btn);
-      gtk_toggle_button_set_mode (GTK_TOGGLE_BUTTON (scale_btn), FALSE);
-      g_object_set_data_full (G_OBJECT (scale_btn),
-                              "scale",
-                              g_memdup (scale, sizeof (gdouble)),
-                              g_free);
-      gtk_widget_show (scale_btn);
-      gtk_container_add (GTK_CONTAINER (self->scale_bbox), scale_btn);
-      g_signal_connect_object (scale_btn,
-                               "notify::active",
-                               G_CALLBACK (on_scale_btn_active_changed_cb),
-                               self, 0);
-
-      if (cc_display_monitor_get_scale (self->selected_output) == *scale)
-        gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (scale_btn), TRUE);
-
-      buttons += 1;
-      if (buttons >= MAX_SCALE_BUTTONS)
-        break;
+      g_array_append_val (shown_scales, *scale);
     }
 
-  gtk_widget_set_visible (self->scale_row, buttons > 1);
+  /* Only recreate the buttons if the offered scales changed */
+  scale_buttons = gtk_container_get_children (GTK_CONTAINER (self->scale_bbox));
+  if (scale_buttons_match (scale_buttons, shown_scales))
+    {
+      GList *l;
+
+      for (l = scale_buttons; l != NULL; l = l->next)
+        {
+          gdouble btn_scale = *(gdouble*) g_object_get_data (G_OBJECT (l->data), "scale");
+
+          if (cc_display_monitor_get_scale (self->selected_output) != btn_scale)
+            continue;
+
+          self->updating = TRUE;
+          gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (l->data), TRUE);
+          self->updating = FALSE;
+        }
+    }
+  else
+    {
+      gtk_container_foreach (GTK_CONTAINER (self->scale_bbox), (GtkCallback) gtk_widget_destroy, NULL);
+
+      for (i = 0; i < shown_scales->len; i++)
+        {
+          g_autofree gchar *scale_str = NULL;
+          GtkWidget *scale_btn;
+
+          scale = &g_array_index (shown_scales, gdouble, i);
+          scale_str = make_scale_string (*scale);
+
+          scale_btn = gtk_radio_button_new_with_label_from_widget (group, scale_str);
+          if (!group)
+            group = GTK_RADIO_BUTTON (scale_btn);
+          gtk_toggle_button_set_mode (GTK_TOGGLE_BUTTON (scale_btn), FALSE);
+          g_object_set_data_full (G_OBJECT (scale_btn),
+                                  "scale",
+                                  g_memdup (scale, sizeof (gdouble)),
+                                  g_free);
+          gtk_widget_show (scale_btn);
+          gtk_container_add (GTK_CONTAINER (self->scale_bbox), scale_btn);
+          g_signal_connect_object (scale_btn,
+                                   "notify::active",
+                                   G_CALLBACK (on_scale_btn_active_changed_cb),
+                                   self, 0);
+
+          if (cc_display_monitor_get_scale (self->selected_output) == *scale)
+            gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (scale_btn), TRUE);
+        }
+    }
+
+  gtk_widget_set_visible (self->scale_row, shown_scales->len > 1);
 
   gtk_widget_set_visible (self->underscanning_row,
                           cc_display_monitor_supports_underscanning (self->selected_output) &&
@@ -441,6 +641,17 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
   g_object_thaw_notify ((GObject*) self->resolution_row);
   g_object_thaw_notify ((GObject*) self->underscanning_switch);
   self->updating = FALSE;
+}
+
+static gboolean
+rebuild_ui_tick_cb (GtkWidget     *widget,
+                    GdkFrameClock *frame_clock,
+                    gpointer       user_data)
+{
+  CcDisplaySettings *self = CC_DISPLAY_SETTINGS (widget);
+
+  self->rebuild_tick_id = 0;
+  cc_display_settings_rebuild_ui (self);
 
   return G_SOURCE_REMOVE;
 }
@@ -450,13 +661,16 @@ on_output_changed_cb (CcDisplaySettings *self,
                       GParamSpec        *pspec,
                       CcDisplayMonitor  *output)
 {
-  /* Do this frmo an idle handler, because otherwise we may create an
+  /* Do this from a tick callback, because otherwise we may create an
    * infinite loop triggering the notify::selected-index from the
-   * combo rows. */
-  if (self->idle_udpate_id)
+   * combo rows. This also coalesces all changes to one rebuild per
+   * frame. */
+  if (self->rebuild_tick_id)
     return;
 
-  self->idle_udpate_id = g_idle_add ((GSourceFunc) cc_display_settings_rebuild_ui, self);
+  self->rebuild_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self),
+                                                        rebuild_ui_tick_cb,
+                                                        NULL, NULL);
 }
 
 static void
@@ -619,9 +833,12 @@ cc_display_settings_finalize (GObject *object)
   g_clear_object (&self->refresh_rate_list);
   g_clear_object (&self->resolution_list);
 
-  if (self->idle_udpate_id)
-    g_source_remove (self->idle_udpate_id);
-  self->idle_udpate_id = 0;
+  if (self->rebuild_tick_id)
+    gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->rebuild_tick_id);
+  self->rebuild_tick_id = 0;
+
+  g_clear_pointer (&self->monitor_modes, g_hash_table_unref);
+  g_clear_pointer (&self->sorted_clone_modes, g_ptr_array_unref);
 
   G_OBJECT_CLASS (cc_display_settings_parent_class)->finalize (object);
 }
@@ -692,6 +909,8 @@ cc_display_settings_init (CcDisplaySettings *self)
   self->orientation_list = g_list_store_new (HDY_TYPE_VALUE_OBJECT);
   self->refresh_rate_list = g_list_store_new (CC_TYPE_DISPLAY_MODE);
   self->resolution_list = g_list_store_new (CC_TYPE_DISPLAY_MODE);
+  self->monitor_modes = g_hash_table_new_full (NULL, NULL, NULL,
+                                               (GDestroyNotify) monitor_modes_free);
 
   self->updating = TRUE;
 
@@ -759,6 +978,7 @@ cc_display_settings_set_config (CcDisplaySettings *self,
         }
     }
   g_clear_object (&self->config);
+  clear_mode_caches (self);
 
   self->config = g_object_ref (config);
 
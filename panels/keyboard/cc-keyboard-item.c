@@ -78,6 +78,27 @@ G_DEFINE_TYPE (CcKeyboardItem, cc_keyboard_item, G_TYPE_OBJECT)
 
 static const CcKeyCombo EMPTY_COMBO = { 0, 0, 0 };
 
+/* Shortcuts of the same schema share one GSettings, which is kept around
+ * so reloading the sections doesn't have to look the schemas up again. */
+static GSettings *
+get_settings_for_schema (const char *schema)
+{
+  static GHashTable *settings_cache = NULL;
+  GSettings *settings;
+
+  if (settings_cache == NULL)
+    settings_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+
+  settings = g_hash_table_lookup (settings_cache, schema);
+  if (settings == NULL)
+    {
+      settings = g_settings_new (schema);
+      g_hash_table_insert (settings_cache, g_strdup (schema), settings);
+    }
+
+  return g_object_ref (settings);
+}
+
 static gboolean
 combo_equal (CcKeyCombo *a, CcKeyCombo *b)
 {
@@ -564,7 +585,7 @@ cc_keyboard_item_load_from_gsettings (CcKeyboardItem *item,
   item->key = g_strdup (key);
   item->description = g_strdup (description);
 
-  item->settings = g_settings_new (item->schema);
+  item->settings = get_settings_for_schema (item->schema);
   item->editable = g_settings_is_writable (item->settings, item->key);
 
   g_list_free_full (item->key_combos, g_free);
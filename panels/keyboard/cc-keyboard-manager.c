@@ -21,6 +21,7 @@
  */
 
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 
 #include "cc-keyboard-manager.h"
 #include "keyboard-shortcuts.h"
@@ -43,6 +44,15 @@ struct _CcKeyboardManager
   GHashTable         *kb_apps_sections;
   GHashTable         *kb_user_sections;
 
+  /* Normalized CcKeyCombo → GPtrArray of the items using it */
+  GHashTable         *combo_index;
+  /* CcKeyboardItem → IndexedItem */
+  GHashTable         *indexed_items;
+
+  /* Path → CachedKeyList */
+  GHashTable         *keylist_cache;
+  GStrv               wm_keybindings;
+
   GSettings          *binding_settings;
 
   gpointer            wm_changed_id;
@@ -60,6 +70,19 @@ enum
 
 static guint signals[LAST_SIGNAL] = { 0, };
 
+typedef struct
+{
+  BindingGroupType  group;
+  GArray           *combos;
+} IndexedItem;
+
+typedef struct
+{
+  gint64    mtime;
+  goffset   size;
+  KeyList  *keylist;
+} CachedKeyList;
+
 /*
  * Auxiliary methos
  */
@@ -83,85 +106,211 @@ free_key_array (GPtrArray *keys)
     }
 }
 
+static void
+cached_keylist_free (CachedKeyList *cached)
+{
+  keylist_free (cached->keylist);
+  g_free (cached);
+}
+
+static void
+indexed_item_free (IndexedItem *indexed)
+{
+  g_array_free (indexed->combos, TRUE);
+  g_free (indexed);
+}
+
+/*
+ * Combos with a keyval match on keyval and mask only, while combos without
+ * one match on keycode and mask, so drop whatever is irrelevant for the key.
+ */
+static void
+normalize_combo (CcKeyCombo       *dest,
+                 const CcKeyCombo *combo)
+{
+  dest->keyval = combo->keyval;
+  dest->keycode = combo->keyval != 0 ? 0 : combo->keycode;
+  dest->mask = combo->mask;
+}
+
+static guint
+key_combo_hash (gconstpointer key)
+{
+  const CcKeyCombo *combo = key;
+
+  return combo->keyval ^ (combo->keycode << 16) ^ ((guint) combo->mask * 31);
+}
+
 static gboolean
-find_conflict (CcUniquenessData *data,
-               CcKeyboardItem   *item)
+key_combo_equal (gconstpointer a,
+                 gconstpointer b)
 {
-  GList *l;
-  gboolean is_conflict = FALSE;
+  const CcKeyCombo *combo_a = a;
+  const CcKeyCombo *combo_b = b;
 
-  if (data->orig_item && cc_keyboard_item_equal (data->orig_item, item))
-    return FALSE;
+  return combo_a->keyval == combo_b->keyval &&
+         combo_a->keycode == combo_b->keycode &&
+         combo_a->mask == combo_b->mask;
+}
+
+static void
+index_item_combos (CcKeyboardManager *self,
+                   CcKeyboardItem    *item,
+                   IndexedItem       *indexed)
+{
+  GList *l;
 
   for (l = cc_keyboard_item_get_key_combos (item); l; l = l->next)
     {
-      CcKeyCombo *combo = l->data;
+      CcKeyCombo combo;
+      GPtrArray *items;
+
+      normalize_combo (&combo, l->data);
 
-      if (data->new_mask != combo->mask)
+      /* Any number of shortcuts can be disabled */
+      if (combo.keyval == 0 && combo.keycode == 0)
         continue;
 
-      if (data->new_keyval != 0)
-        is_conflict = data->new_keyval == combo->keyval;
-      else
-        is_conflict = combo->keyval == 0 && data->new_keycode == combo->keycode;
+      items = g_hash_table_lookup (self->combo_index, &combo);
+      if (items == NULL)
+        {
+          CcKeyCombo *key = g_new (CcKeyCombo, 1);
+
+          *key = combo;
+          items = g_ptr_array_new ();
+          g_hash_table_insert (self->combo_index, key, items);
+        }
+      else if (g_ptr_array_find (items, item, NULL))
+        {
+          continue;
+        }
+
+      g_ptr_array_add (items, item);
+      g_array_append_val (indexed->combos, combo);
+    }
+}
+
+static void
+unindex_item_combos (CcKeyboardManager *self,
+                     CcKeyboardItem    *item,
+                     IndexedItem       *indexed)
+{
+  guint i;
 
-      if (is_conflict)
-        break;
+  for (i = 0; i < indexed->combos->len; i++)
+    {
+      CcKeyCombo *combo = &g_array_index (indexed->combos, CcKeyCombo, i);
+      GPtrArray *items;
+
+      items = g_hash_table_lookup (self->combo_index, combo);
+      if (items == NULL)
+        continue;
+
+      g_ptr_array_remove (items, item);
+      if (items->len == 0)
+        g_hash_table_remove (self->combo_index, combo);
     }
 
-  if (is_conflict)
-    data->conflict_item = item;
+  g_array_set_size (indexed->combos, 0);
+}
 
-  return is_conflict;
+static void
+on_item_key_combos_changed_cb (CcKeyboardItem    *item,
+                               GParamSpec        *pspec,
+                               CcKeyboardManager *self)
+{
+  IndexedItem *indexed;
+
+  indexed = g_hash_table_lookup (self->indexed_items, item);
+  if (indexed == NULL)
+    return;
+
+  unindex_item_combos (self, item, indexed);
+  index_item_combos (self, item, indexed);
 }
 
-static gboolean
-compare_keys_for_uniqueness (CcKeyboardItem   *current_item,
-                             CcUniquenessData *data)
+static void
+collision_index_add_item (CcKeyboardManager *self,
+                          CcKeyboardItem    *item,
+                          BindingGroupType   group)
 {
-  CcKeyboardItem *reverse_item;
+  IndexedItem *indexed;
 
-  /* No conflict for: blanks or ourselves */
-  if (!current_item || data->orig_item == current_item)
-    return FALSE;
+  if (g_hash_table_contains (self->indexed_items, item))
+    return;
 
-  reverse_item = cc_keyboard_item_get_reverse_item (current_item);
+  indexed = g_new0 (IndexedItem, 1);
+  indexed->group = group;
+  indexed->combos = g_array_new (FALSE, FALSE, sizeof (CcKeyCombo));
+  g_hash_table_insert (self->indexed_items, item, indexed);
 
-  /* When the current item is the reversed shortcut of a main item, simply ignore it */
-  if (reverse_item && cc_keyboard_item_is_hidden (current_item))
-    return FALSE;
+  index_item_combos (self, item, indexed);
 
-  if (find_conflict (data, current_item))
-    return TRUE;
+  g_signal_connect_object (item,
+                           "notify::key-combos",
+                           G_CALLBACK (on_item_key_combos_changed_cb),
+                           self,
+                           0);
+}
 
-  /* Also check for the reverse item if any */
-  if (reverse_item && find_conflict (data, reverse_item))
-    return TRUE;
+static void
+collision_index_remove_item (CcKeyboardManager *self,
+                             CcKeyboardItem    *item)
+{
+  IndexedItem *indexed;
 
-  return FALSE;
+  indexed = g_hash_table_lookup (self->indexed_items, item);
+  if (indexed == NULL)
+    return;
+
+  g_signal_handlers_disconnect_by_func (item, on_item_key_combos_changed_cb, self);
+  unindex_item_combos (self, item, indexed);
+  g_hash_table_remove (self->indexed_items, item);
+}
+
+static void
+collision_index_clear (CcKeyboardManager *self)
+{
+  GHashTableIter iter;
+  CcKeyboardItem *item;
+
+  g_hash_table_iter_init (&iter, self->indexed_items);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &item, NULL))
+    g_signal_handlers_disconnect_by_func (item, on_item_key_combos_changed_cb, self);
+
+  g_hash_table_remove_all (self->indexed_items);
+  g_hash_table_remove_all (self->combo_index);
 }
 
+/*
+ * Hidden items that are the reverse of another shortcut are only
+ * considered through their visible counterpart.
+ */
 static gboolean
-check_for_uniqueness (gpointer          key,
-                      GPtrArray        *keys_array,
-                      CcUniquenessData *data)
+item_can_conflict (CcKeyboardItem *orig_item,
+                   CcKeyboardItem *item)
 {
-  guint i;
+  CcKeyboardItem *reverse_item;
 
-  for (i = 0; i < keys_array->len; i++)
-    {
-      CcKeyboardItem *item;
+  /* No conflict for ourselves */
+  if (orig_item && (orig_item == item || cc_keyboard_item_equal (orig_item, item)))
+    return FALSE;
 
-      item = keys_array->pdata[i];
+  reverse_item = cc_keyboard_item_get_reverse_item (item);
+  if (reverse_item && cc_keyboard_item_is_hidden (item))
+    {
+      /* Nor for our own reversed shortcut */
+      if (reverse_item == orig_item)
+        return FALSE;
 
-      if (compare_keys_for_uniqueness (item, data))
-        return TRUE;
+      if (cc_keyboard_item_is_hidden (reverse_item) &&
+          cc_keyboard_item_get_reverse_item (reverse_item) != NULL)
+        return FALSE;
     }
 
-  return FALSE;
+  return TRUE;
 }
 
-
 static GHashTable*
 get_hash_for_group (CcKeyboardManager *self,
                     BindingGroupType   group)
@@ -350,6 +499,7 @@ append_section (CcKeyboardManager  *self,
       cc_keyboard_item_set_hidden (item, keys_list[i].hidden);
 
       g_ptr_array_add (keys_array, item);
+      collision_index_add_item (self, item, group);
     }
 
   g_hash_table_destroy (reverse_items);
@@ -370,6 +520,48 @@ append_section (CcKeyboardManager  *self,
     }
 }
 
+/*
+ * Returns the parsed key list for @path, only parsing the file again when it
+ * changed since the last reload. The entries are terminated by an empty one.
+ */
+static KeyList *
+get_keylist_for_file (CcKeyboardManager *self,
+                      const gchar       *path)
+{
+  KeyListEntry key = { 0, 0, 0, 0, 0, 0, 0 };
+  CachedKeyList *cached;
+  GStatBuf buf;
+  KeyList *keylist;
+
+  if (g_stat (path, &buf) != 0)
+    {
+      g_hash_table_remove (self->keylist_cache, path);
+      return NULL;
+    }
+
+  cached = g_hash_table_lookup (self->keylist_cache, path);
+  if (cached && cached->mtime == buf.st_mtime && cached->size == buf.st_size)
+    return cached->keylist;
+
+  keylist = parse_keylist_from_file (path);
+  if (keylist == NULL)
+    {
+      g_hash_table_remove (self->keylist_cache, path);
+      return NULL;
+    }
+
+  /* Empty KeyListEntry to end the array */
+  g_array_append_val (keylist->entries, key);
+
+  cached = g_new0 (CachedKeyList, 1);
+  cached->mtime = buf.st_mtime;
+  cached->size = buf.st_size;
+  cached->keylist = keylist;
+  g_hash_table_insert (self->keylist_cache, g_strdup (path), cached);
+
+  return keylist;
+}
+
 static void
 append_sections_from_file (CcKeyboardManager  *self,
                            const gchar        *path,
@@ -377,40 +569,26 @@ append_sections_from_file (CcKeyboardManager  *self,
                            gchar             **wm_keybindings)
 {
   KeyList *keylist;
-  KeyListEntry *keys;
-  KeyListEntry key = { 0, 0, 0, 0, 0, 0, 0 };
   const char *title;
   int group;
-  guint i;
 
-  keylist = parse_keylist_from_file (path);
+  keylist = get_keylist_for_file (self, path);
 
   if (keylist == NULL)
     return;
 
 #define const_strv(s) ((const gchar* const*) s)
 
-  /* If there's no keys to add, or the settings apply to a window manager
-   * that's not the one we're running */
-  if (keylist->entries->len == 0 ||
+  /* If there's no keys to add (the list always holds the terminating
+   * entry), or the settings apply to a window manager that's not the
+   * one we're running */
+  if (keylist->entries->len <= 1 ||
       (keylist->wm_name != NULL && !g_strv_contains (const_strv (wm_keybindings), keylist->wm_name)) ||
       keylist->name == NULL)
-    {
-      g_free (keylist->name);
-      g_free (keylist->package);
-      g_free (keylist->wm_name);
-      g_array_free (keylist->entries, TRUE);
-      g_free (keylist);
-      return;
-    }
+    return;
 
 #undef const_strv
 
-  /* Empty KeyListEntry to end the array */
-  key.name = NULL;
-  g_array_append_val (keylist->entries, key);
-
-  keys = (KeyListEntry *) g_array_free (keylist->entries, FALSE);
   if (keylist->package)
     {
       g_autofree gchar *localedir = NULL;
@@ -428,25 +606,7 @@ append_sections_from_file (CcKeyboardManager  *self,
   else
     group = BINDING_GROUP_APPS;
 
-  append_section (self, title, keylist->name, group, keys);
-
-  g_free (keylist->name);
-  g_free (keylist->package);
-  g_free (keylist->wm_name);
-  g_free (keylist->schema);
-  g_free (keylist->group);
-
-  for (i = 0; keys[i].name != NULL; i++)
-    {
-      KeyListEntry *entry = &keys[i];
-      g_free (entry->schema);
-      g_free (entry->description);
-      g_free (entry->name);
-      g_free (entry->reverse_entry);
-    }
-
-  g_free (keylist);
-  g_free (keys);
+  append_section (self, title, keylist->name, group, (KeyListEntry *) keylist->entries->data);
 }
 
 static void
@@ -497,12 +657,42 @@ append_sections_from_gsettings (CcKeyboardManager *self)
   g_array_free (entries, TRUE);
 }
 
+static GStrv
+get_wm_keybindings (void)
+{
+  gchar *default_wm_keybindings[] = { "Mutter", "GNOME Shell", NULL };
+
+#ifdef GDK_WINDOWING_X11
+  if (GDK_IS_X11_DISPLAY (gdk_display_get_default ()))
+    return wm_common_get_current_keybindings ();
+#endif
+
+  return g_strdupv (default_wm_keybindings);
+}
+
+static gboolean
+strv_equal (GStrv a,
+            GStrv b)
+{
+  guint i;
+
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  for (i = 0; a[i] != NULL && b[i] != NULL; i++)
+    {
+      if (g_strcmp0 (a[i], b[i]) != 0)
+        return FALSE;
+    }
+
+  return a[i] == b[i];
+}
+
 static void
 reload_sections (CcKeyboardManager *self)
 {
   GHashTable *loaded_files;
   GDir *dir;
-  gchar *default_wm_keybindings[] = { "Mutter", "GNOME Shell", NULL };
   g_auto(GStrv) wm_keybindings = NULL;
   const gchar * const * data_dirs;
   guint i;
@@ -510,6 +700,8 @@ reload_sections (CcKeyboardManager *self)
   /* Clear previous models and hash tables */
   gtk_list_store_clear (GTK_LIST_STORE (self->sections_store));
 
+  collision_index_clear (self);
+
   g_clear_pointer (&self->kb_system_sections, g_hash_table_destroy);
   self->kb_system_sections = g_hash_table_new_full (g_str_hash,
                                                     g_str_equal,
@@ -529,12 +721,10 @@ reload_sections (CcKeyboardManager *self)
                                                   (GDestroyNotify) free_key_array);
 
   /* Load WM keybindings */
-#ifdef GDK_WINDOWING_X11
-  if (GDK_IS_X11_DISPLAY (gdk_display_get_default ()))
-    wm_keybindings = wm_common_get_current_keybindings ();
-  else
-#endif
-    wm_keybindings = g_strdupv (default_wm_keybindings);
+  wm_keybindings = get_wm_keybindings ();
+
+  g_strfreev (self->wm_keybindings);
+  self->wm_keybindings = g_strdupv (wm_keybindings);
 
   loaded_files = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
@@ -584,6 +774,13 @@ static void
 on_window_manager_change (const char        *wm_name,
                           CcKeyboardManager *self)
 {
+  g_auto(GStrv) wm_keybindings = NULL;
+
+  /* Window managers sharing the same keybindings show the same sections */
+  wm_keybindings = get_wm_keybindings ();
+  if (strv_equal (wm_keybindings, self->wm_keybindings))
+    return;
+
   reload_sections (self);
 }
 
@@ -592,6 +789,11 @@ cc_keyboard_manager_finalize (GObject *object)
 {
   CcKeyboardManager *self = (CcKeyboardManager *)object;
 
+  collision_index_clear (self);
+  g_clear_pointer (&self->combo_index, g_hash_table_destroy);
+  g_clear_pointer (&self->indexed_items, g_hash_table_destroy);
+  g_clear_pointer (&self->keylist_cache, g_hash_table_destroy);
+  g_clear_pointer (&self->wm_keybindings, g_strfreev);
   g_clear_pointer (&self->kb_system_sections, g_hash_table_destroy);
   g_clear_pointer (&self->kb_apps_sections, g_hash_table_destroy);
   g_clear_pointer (&self->kb_user_sections, g_hash_table_destroy);
@@ -678,6 +880,21 @@ cc_keyboard_manager_init (CcKeyboardManager *self)
   /* Bindings */
   self->binding_settings = g_settings_new (BINDINGS_SCHEMA);
 
+  /* Collision index */
+  self->combo_index = g_hash_table_new_full (key_combo_hash,
+                                             key_combo_equal,
+                                             g_free,
+                                             (GDestroyNotify) g_ptr_array_unref);
+  self->indexed_items = g_hash_table_new_full (NULL,
+                                               NULL,
+                                               NULL,
+                                               (GDestroyNotify) indexed_item_free);
+
+  self->keylist_cache = g_hash_table_new_full (g_str_hash,
+                                               g_str_equal,
+                                               g_free,
+                                               (GDestroyNotify) cached_keylist_free);
+
   /* Setup the section models */
   self->sections_store = gtk_list_store_new (SECTION_N_COLUMNS,
                                              G_TYPE_STRING,
@@ -760,6 +977,7 @@ cc_keyboard_manager_add_custom_shortcut (CcKeyboardManager *self,
     }
 
   g_ptr_array_add (keys_array, item);
+  collision_index_add_item (self, item, BINDING_GROUP_USER);
 
   settings_paths = g_settings_get_strv (self->binding_settings, "custom-keybindings");
 
@@ -824,6 +1042,7 @@ cc_keyboard_manager_remove_custom_shortcut  (CcKeyboardManager *self,
 
   keys_array = g_hash_table_lookup (get_hash_for_group (self, BINDING_GROUP_USER), CUSTOM_SHORTCUTS_ID);
   g_ptr_array_remove (keys_array, item);
+  collision_index_remove_item (self, item);
 
   g_signal_emit (self, signals[SHORTCUT_REMOVED], 0, item);
 }
@@ -843,34 +1062,42 @@ cc_keyboard_manager_get_collision (CcKeyboardManager *self,
                                    CcKeyboardItem    *item,
                                    CcKeyCombo        *combo)
 {
-  CcUniquenessData data;
-  BindingGroupType i;
+  CcKeyboardItem *conflict_item = NULL;
+  BindingGroupType conflict_group = BINDING_GROUP_USER;
+  CcKeyCombo key;
+  GPtrArray *items;
+  guint i;
 
   g_return_val_if_fail (CC_IS_KEYBOARD_MANAGER (self), NULL);
 
-  data.orig_item = item;
-  data.new_keyval = combo->keyval;
-  data.new_mask = combo->mask;
-  data.new_keycode = combo->keycode;
-  data.conflict_item = NULL;
-
+  /* Any number of shortcuts can be disabled */
   if (combo->keyval == 0 && combo->keycode == 0)
     return NULL;
 
-  /* Any number of shortcuts can be disabled */
-  for (i = BINDING_GROUP_SYSTEM; i <= BINDING_GROUP_USER && !data.conflict_item; i++)
-    {
-      GHashTable *table;
+  normalize_combo (&key, combo);
 
-      table = get_hash_for_group (self, i);
+  items = g_hash_table_lookup (self->combo_index, &key);
+  if (items == NULL)
+    return NULL;
+
+  /* System shortcuts take precedence over application and user ones */
+  for (i = 0; i < items->len; i++)
+    {
+      CcKeyboardItem *candidate = g_ptr_array_index (items, i);
+      IndexedItem *indexed;
 
-      if (!table)
+      if (!item_can_conflict (item, candidate))
         continue;
 
-      g_hash_table_find (table, (GHRFunc) check_for_uniqueness, &data);
+      indexed = g_hash_table_lookup (self->indexed_items, candidate);
+      if (conflict_item == NULL || indexed->group < conflict_group)
+        {
+          conflict_item = candidate;
+          conflict_group = indexed->group;
+        }
     }
 
-  return data.conflict_item;
+  return conflict_item;
 }
 
 /**
@@ -319,7 +319,6 @@ parse_keylist_from_file (const gchar *path)
   g_autoptr(GError) err = NULL;
   g_autofree gchar *buf = NULL;
   gsize buf_len;
-  guint i;
 
   g_autoptr(GMarkupParseContext) ctx = NULL;
   GMarkupParser parser = { parse_start_tag, NULL, NULL, NULL, NULL };
@@ -335,21 +334,40 @@ parse_keylist_from_file (const gchar *path)
   if (!g_markup_parse_context_parse (ctx, buf, buf_len, &err))
     {
       g_warning ("Failed to parse '%s': '%s'", path, err->message);
-      g_free (keylist->name);
-      g_free (keylist->package);
-      g_free (keylist->wm_name);
-
-      for (i = 0; i < keylist->entries->len; i++)
-        g_free (((KeyListEntry *) &(keylist->entries->data[i]))->name);
-
-      g_array_free (keylist->entries, TRUE);
-      g_free (keylist);
+      keylist_free (keylist);
       return NULL;
     }
 
   return keylist;
 }
 
+void
+keylist_free (KeyList *keylist)
+{
+  guint i;
+
+  if (keylist == NULL)
+    return;
+
+  for (i = 0; i < keylist->entries->len; i++)
+    {
+      KeyListEntry *entry = &g_array_index (keylist->entries, KeyListEntry, i);
+
+      g_free (entry->schema);
+      g_free (entry->description);
+      g_free (entry->name);
+      g_free (entry->reverse_entry);
+    }
+
+  g_array_free (keylist->entries, TRUE);
+  g_free (keylist->name);
+  g_free (keylist->group);
+  g_free (keylist->package);
+  g_free (keylist->wm_name);
+  g_free (keylist->schema);
+  g_free (keylist);
+}
+
 /*
  * Stolen from GtkCellRendererAccel:
  * https://git.gnome.org/browse/gtk+/tree/gtk/gtkcellrendereraccel.c#n261
@@ -49,14 +49,6 @@ typedef struct
   gboolean hidden;
 } KeyListEntry;
 
-typedef struct {
-  CcKeyboardItem *orig_item;
-  CcKeyboardItem *conflict_item;
-  guint new_keyval;
-  GdkModifierType new_mask;
-  guint new_keycode;
-} CcUniquenessData;
-
 enum
 {
   SECTION_DESCRIPTION_COLUMN,
@@ -75,4 +67,6 @@ gboolean is_valid_accel                 (const CcKeyCombo *combo);
 
 KeyList* parse_keylist_from_file        (const gchar *path);
 
+void     keylist_free                   (KeyList *keylist);
+
 gchar*   convert_keysym_state_to_string (const CcKeyCombo *combo);
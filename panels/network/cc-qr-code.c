@@ -102,18 +102,107 @@ cc_qr_code_set_text (CcQrCode    *self,
   return TRUE;
 }
 
+#define QR_COLOR_WHITE 0xffffffff
+#define QR_COLOR_BLACK 0xff000000
+
+static void
+get_module_layout (gint  size,
+                   gint  qr_size,
+                   gint *pixel_size,
+                   gint *padding)
+{
+  *pixel_size = MAX (1, size / (qr_size));
+  *padding = (size - qr_size * *pixel_size) / 2;
+
+  /* If subpixel size is big and margin is pretty small,
+   * increase the margin */
+  if (*pixel_size > 4 && *padding < 12)
+    {
+      (*pixel_size)--;
+      *padding = (size - qr_size * *pixel_size) / 2;
+    }
+}
+
+static void
+fill_span (guint32 *line,
+           gint     width,
+           gint     start,
+           gint     end,
+           guint32  color)
+{
+  start = CLAMP (start, 0, width);
+  end = CLAMP (end, 0, width);
+
+  for (gint i = start; i < end; i++)
+    line[i] = color;
+}
+
+/* Renders the modules straight into the surface data. Every module row is
+ * rendered once, with runs of dark modules filled in one go, and then copied
+ * to all device pixel rows it covers. */
 static void
-cc_cairo_fill_pixel (cairo_t *cr,
-                     int      x,
-                     int      y,
-                     int      padding,
-                     int      scale)
+render_qr_code (cairo_surface_t *surface,
+                const uint8_t   *qr_code,
+                gint             size,
+                gint             scale)
 {
-  cairo_rectangle (cr,
-                   x * scale + padding,
-                   y * scale + padding,
-                   scale, scale);
-  cairo_fill (cr);
+  g_autofree guint32 *white_line = NULL;
+  g_autofree guint32 *line = NULL;
+  guchar *data;
+  gint width, stride, qr_size;
+  gint pixel_size, padding, module_size, offset;
+
+  width = size * scale;
+  data = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+
+  qr_size = qrcodegen_getSize (qr_code);
+  get_module_layout (size, qr_size, &pixel_size, &padding);
+  module_size = pixel_size * scale;
+  offset = padding * scale;
+
+  white_line = g_new (guint32, width);
+  fill_span (white_line, width, 0, width, QR_COLOR_WHITE);
+  line = g_new (guint32, width);
+
+  for (gint y = 0; y < width; y++)
+    memcpy (data + y * stride, white_line, width * sizeof (guint32));
+
+  for (gint row = 0; row < qr_size; row++)
+    {
+      gint y_start, y_end;
+      gboolean dark_row = FALSE;
+
+      y_start = CLAMP (offset + row * module_size, 0, width);
+      y_end = CLAMP (offset + (row + 1) * module_size, 0, width);
+      if (y_start == y_end)
+        continue;
+
+      memcpy (line, white_line, width * sizeof (guint32));
+
+      for (gint column = 0; column < qr_size; column++)
+        {
+          gint run_start = column;
+
+          if (!qrcodegen_getModule (qr_code, row, column))
+            continue;
+
+          while (column + 1 < qr_size && qrcodegen_getModule (qr_code, row, column + 1))
+            column++;
+
+          fill_span (line, width,
+                     offset + run_start * module_size,
+                     offset + (column + 1) * module_size,
+                     QR_COLOR_BLACK);
+          dark_row = TRUE;
+        }
+
+      if (!dark_row)
+        continue;
+
+      for (gint y = y_start; y < y_end; y++)
+        memcpy (data + y * stride, line, width * sizeof (guint32));
+    }
 }
 
 cairo_surface_t *
@@ -123,8 +212,6 @@ cc_qr_code_get_surface (CcQrCode *self,
 {
   uint8_t qr_code[qrcodegen_BUFFER_LEN_FOR_VERSION (qrcodegen_VERSION_MAX)];
   uint8_t temp_buf[qrcodegen_BUFFER_LEN_FOR_VERSION (qrcodegen_VERSION_MAX)];
-  cairo_t *cr;
-  gint pixel_size, padding, qr_size;
   gboolean success = FALSE;
 
   g_return_val_if_fail (CC_IS_QR_CODE (self), NULL);
@@ -159,39 +246,16 @@ cc_qr_code_get_surface (CcQrCode *self,
     return NULL;
 
   self->surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24, size * scale, size * scale);
-  cairo_surface_set_device_scale (self->surface, scale, scale);
-  cr = cairo_create (self->surface);
-  cairo_set_antialias (cr, CAIRO_ANTIALIAS_NONE);
-
-  /* Draw white background */
-  cairo_set_source_rgba (cr, 1, 1, 1, 1);
-  cairo_rectangle (cr, 0, 0, size * scale, size * scale);
-  cairo_fill (cr);
-
-  qr_size = qrcodegen_getSize(qr_code);
-  pixel_size = MAX (1, size / (qr_size));
-  padding = (size - qr_size * pixel_size) / 2;
-
-  /* If subpixel size is big and margin is pretty small,
-   * increase the margin */
-  if (pixel_size > 4 && padding < 12)
+  if (cairo_surface_status (self->surface) != CAIRO_STATUS_SUCCESS)
     {
-      pixel_size--;
-      padding = (size - qr_size * pixel_size) / 2;
+      g_clear_pointer (&self->surface, cairo_surface_destroy);
+      return NULL;
     }
 
-  /* Now draw the black QR code pixels */
-  cairo_set_source_rgba (cr, 0, 0, 0, 1);
-  for (int row = 0; row < qr_size; row++)
-    {
-      for (int column = 0; column < qr_size; column++)
-        {
-          if (qrcodegen_getModule (qr_code, row, column))
-            cc_cairo_fill_pixel (cr, column, row, padding, pixel_size);
-        }
-    }
-
-  cairo_destroy (cr);
+  cairo_surface_flush (self->surface);
+  render_qr_code (self->surface, qr_code, size, scale);
+  cairo_surface_mark_dirty (self->surface);
+  cairo_surface_set_device_scale (self->surface, scale, scale);
 
   return self->surface;
 }
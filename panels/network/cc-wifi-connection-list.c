@@ -48,6 +48,18 @@ struct _CcWifiConnectionList
    */
   GHashTable    *ap_ssid_cache;
   GHashTable    *ssid_to_row;
+
+  /* Reverse indexes so that AP and connection changes do not need to scan
+   * all rows. connection_to_idx maps a connection to its index (plus one)
+   * in connections/connections_row, ap_to_rows maps an AP to the array of
+   * connection rows it has been added to. */
+  GHashTable    *connection_to_idx;
+  GHashTable    *ap_to_rows;
+
+  /* AP property changes (mostly strength) are frequent, so the affected
+   * rows are collected and updated once per frame. */
+  GHashTable    *pending_rows;
+  guint          pending_tick_id;
 };
 
 static void on_device_ap_added_cb   (CcWifiConnectionList *self,
@@ -91,6 +103,23 @@ new_hashable_ssid (GBytes *ssid)
   return res;
 }
 
+static gboolean
+find_connection (CcWifiConnectionList *self,
+                 NMConnection         *connection,
+                 guint                *idx)
+{
+  guint value;
+
+  value = GPOINTER_TO_UINT (g_hash_table_lookup (self->connection_to_idx, connection));
+  if (value == 0)
+    return FALSE;
+
+  if (idx)
+    *idx = value - 1;
+
+  return TRUE;
+}
+
 static gboolean
 connection_ignored (NMConnection *connection)
 {
@@ -173,6 +202,9 @@ clear_widget (CcWifiConnectionList *self)
   g_ptr_array_set_size (self->connections_row, 0);
   g_hash_table_remove_all (self->ssid_to_row);
   g_hash_table_remove_all (self->ap_ssid_cache);
+  g_hash_table_remove_all (self->connection_to_idx);
+  g_hash_table_remove_all (self->ap_to_rows);
+  g_hash_table_remove_all (self->pending_rows);
 }
 
 static void
@@ -223,6 +255,8 @@ update_connections (CcWifiConnectionList *self)
         continue;
 
       g_ptr_array_add (self->connections, g_object_ref (con));
+      g_hash_table_insert (self->connection_to_idx, con,
+                           GUINT_TO_POINTER (self->connections->len));
       if (self->hide_unavailable && con != ac_con)
         g_ptr_array_add (self->connections_row, NULL);
       else
@@ -245,40 +279,128 @@ on_row_configured_cb (CcWifiConnectionList *self, CcWifiConnectionRow *row)
   g_signal_emit_by_name (self, "configure", row);
 }
 
+static gboolean
+update_pending_rows_cb (GtkWidget     *widget,
+                        GdkFrameClock *frame_clock,
+                        gpointer       user_data)
+{
+  CcWifiConnectionList *self = CC_WIFI_CONNECTION_LIST (widget);
+  GHashTableIter iter;
+  CcWifiConnectionRow *row;
+
+  self->pending_tick_id = 0;
+
+  /* Rows may have been removed in the meantime */
+  g_hash_table_iter_init (&iter, self->pending_rows);
+  while (g_hash_table_iter_next (&iter, (gpointer*) &row, NULL))
+    {
+      if (gtk_widget_get_parent (GTK_WIDGET (row)) == widget)
+        cc_wifi_connection_row_update (row);
+    }
+  g_hash_table_remove_all (self->pending_rows);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+queue_row_update (CcWifiConnectionList *self,
+                  CcWifiConnectionRow  *row)
+{
+  if (!g_hash_table_contains (self->pending_rows, row))
+    g_hash_table_add (self->pending_rows, g_object_ref (row));
+
+  if (self->pending_tick_id == 0)
+    self->pending_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self),
+                                                          update_pending_rows_cb,
+                                                          NULL, NULL);
+}
+
+/* Handles an SSID change of an AP that is only grouped by its SSID without
+ * touching the row, as long as it still does not match any connection.
+ * Returns FALSE if the AP needs to be removed and added again instead. */
+static gboolean
+update_access_point_ssid (CcWifiConnectionList *self,
+                          NMAccessPoint        *ap)
+{
+  g_autoptr(GPtrArray) connections = NULL;
+  g_autoptr(GBytes) ssid = NULL;
+  CcWifiConnectionRow *row;
+  const GPtrArray *row_aps;
+  GBytes *old_ssid;
+  GBytes *ap_ssid;
+
+  if (!self->show_aps)
+    return FALSE;
+
+  old_ssid = g_hash_table_lookup (self->ap_ssid_cache, ap);
+  if (!old_ssid)
+    return FALSE;
+
+  ap_ssid = nm_access_point_get_ssid (ap);
+  if (ap_ssid == NULL || ap == nm_device_wifi_get_active_access_point (self->device))
+    return FALSE;
+
+  connections = nm_access_point_filter_connections (ap, self->connections);
+  if (connections->len > 0)
+    return FALSE;
+
+  ssid = new_hashable_ssid (ap_ssid);
+  row = g_hash_table_lookup (self->ssid_to_row, old_ssid);
+  g_assert (row != NULL);
+
+  if (!g_bytes_equal (ssid, old_ssid))
+    {
+      /* Only move the row if the AP is alone in it and does not need to be
+       * merged into the row of another SSID. */
+      row_aps = cc_wifi_connection_row_get_access_points (row);
+      if (row_aps->len != 1 || g_hash_table_contains (self->ssid_to_row, ssid))
+        return FALSE;
+
+      g_hash_table_remove (self->ssid_to_row, old_ssid);
+      g_hash_table_insert (self->ssid_to_row, g_bytes_ref (ssid), row);
+      g_hash_table_insert (self->ap_ssid_cache, ap, g_bytes_ref (ssid));
+    }
+
+  cc_wifi_connection_row_update (row);
+
+  return TRUE;
+}
+
 static void
 on_access_point_property_changed (CcWifiConnectionList *self,
                                   GParamSpec           *pspec,
                                   NMAccessPoint        *ap)
 {
   CcWifiConnectionRow *row;
+  GPtrArray *rows;
   GBytes *ssid;
-  gboolean has_connection = FALSE;
-  gint i;
+  guint i;
 
-  /* If the SSID changed then the AP needs to be added/removed from rows.
-   * Do this by simulating an AP addition/removal.  */
+  /* If the SSID changed then the AP may need to be added/removed from rows.
+   * Unless it can be updated in place, do this by simulating an AP
+   * addition/removal.  */
   if (g_str_equal (pspec->name, NM_ACCESS_POINT_SSID))
     {
+      if (update_access_point_ssid (self, ap))
+        return;
+
       g_debug ("Simulating add/remove for SSID change");
       on_device_ap_removed_cb (self, ap, self->device);
       on_device_ap_added_cb (self, ap, self->device);
       return;
     }
 
-  /* Otherwise, find all rows that contain the AP and update it. Do this by
-   * first searching all rows with connections, and then looking it up in the
-   * SSID rows if not found. */
-  for (i = 0; i < self->connections_row->len; i++)
+  /* Otherwise, queue an update of all rows that contain the AP. These are
+   * either rows with connections, or the row for its SSID. */
+  rows = g_hash_table_lookup (self->ap_to_rows, ap);
+  if (rows && rows->len > 0)
     {
-      row = g_ptr_array_index (self->connections_row, i);
-      if (row && cc_wifi_connection_row_has_access_point (row, ap))
-        {
-          cc_wifi_connection_row_update (row);
-          has_connection = TRUE;
-        }
+      for (i = 0; i < rows->len; i++)
+        queue_row_update (self, g_ptr_array_index (rows, i));
+      return;
     }
 
-  if (!self->show_aps || has_connection)
+  if (!self->show_aps)
     return;
 
   ssid = g_hash_table_lookup (self->ap_ssid_cache, ap);
@@ -289,7 +411,7 @@ on_access_point_property_changed (CcWifiConnectionList *self,
   if (!row)
     g_assert_not_reached ();
   else
-    cc_wifi_connection_row_update (row);
+    queue_row_update (self, row);
 }
 
 static void
@@ -299,6 +421,7 @@ on_device_ap_added_cb (CcWifiConnectionList *self,
 {
   g_autoptr(GPtrArray) connections = NULL;
   CcWifiConnectionRow *row;
+  GPtrArray *rows;
   GBytes *ap_ssid;
   g_autoptr(GBytes) ssid = NULL;
   guint i, j;
@@ -324,12 +447,10 @@ on_device_ap_added_cb (CcWifiConnectionList *self,
 
       if (ac)
         {
-          guint idx;
-
           ac_con = NM_CONNECTION (nm_active_connection_get_connection (ac));
 
           if (!g_ptr_array_find (connections, ac_con, NULL) &&
-              g_ptr_array_find (self->connections, ac_con, &idx))
+              find_connection (self, ac_con, NULL))
             {
               g_debug ("Adding active connection to list of valid connections for AP");
               g_ptr_array_add (connections, g_object_ref (ac_con));
@@ -338,9 +459,10 @@ on_device_ap_added_cb (CcWifiConnectionList *self,
     }
 
   /* Add the AP to all connection related rows, creating the row if neccessary. */
+  rows = g_hash_table_lookup (self->ap_to_rows, ap);
   for (i = 0; i < connections->len; i++)
     {
-      gboolean found = g_ptr_array_find (self->connections, g_ptr_array_index (connections, i), &j);
+      gboolean found = find_connection (self, g_ptr_array_index (connections, i), &j);
 
       g_assert (found);
 
@@ -349,6 +471,13 @@ on_device_ap_added_cb (CcWifiConnectionList *self,
         row = cc_wifi_connection_list_row_add (self, g_ptr_array_index (connections, i), NULL);
       cc_wifi_connection_row_add_access_point (row, ap);
       g_ptr_array_index (self->connections_row, j) = row;
+
+      if (!rows)
+        {
+          rows = g_ptr_array_new ();
+          g_hash_table_insert (self->ap_to_rows, ap, rows);
+        }
+      g_ptr_array_add (rows, row);
     }
 
   if (connections->len > 0)
@@ -386,24 +515,27 @@ on_device_ap_removed_cb (CcWifiConnectionList *self,
                          NMDeviceWifi         *device)
 {
   CcWifiConnectionRow *row;
+  g_autoptr(GPtrArray) rows = NULL;
   g_autoptr(GBytes) ssid = NULL;
   gboolean found = FALSE;
-  gint i;
+  guint i, idx;
 
   g_signal_handlers_disconnect_by_data (ap, self);
 
-  /* Find any connection related row with the AP and remove the AP from it. Remove the
+  /* Remove the AP from all connection related rows it was added to. Remove the
    * row if it was the last AP and we are hiding unavailable connections. */
-  for (i = 0; i < self->connections_row->len; i++)
+  g_hash_table_steal_extended (self->ap_to_rows, ap, NULL, (gpointer*) &rows);
+  for (i = 0; rows && i < rows->len; i++)
     {
-      row = g_ptr_array_index (self->connections_row, i);
-      if (row && cc_wifi_connection_row_remove_access_point (row, ap))
+      row = g_ptr_array_index (rows, i);
+      if (cc_wifi_connection_row_remove_access_point (row, ap))
         {
           found = TRUE;
 
-          if (self->hide_unavailable)
+          if (self->hide_unavailable &&
+              find_connection (self, cc_wifi_connection_row_get_connection (row), &idx))
             {
-              g_ptr_array_index (self->connections_row, i) = NULL;
+              g_ptr_array_index (self->connections_row, idx) = NULL;
               gtk_container_remove (GTK_CONTAINER (self), GTK_WIDGET (row));
             }
         }
@@ -451,7 +583,7 @@ on_client_connection_removed_cb (CcWifiConnectionList *self,
                                  NMConnection         *connection,
                                  NMClient             *client)
 {
-  if (!g_ptr_array_find (self->connections, connection, NULL))
+  if (!find_connection (self, connection, NULL))
     return;
 
   /* The approach we take to handle connection changes is to do a full rebuild.
@@ -475,7 +607,7 @@ on_device_state_changed_cb (CcWifiConnectionList *self,
 
   /* Just update the corresponding row if the AC is still the same. */
   if (self->last_active == connection &&
-      g_ptr_array_find (self->connections, connection, &idx) &&
+      find_connection (self, connection, &idx) &&
       g_ptr_array_index (self->connections_row, idx))
     {
       cc_wifi_connection_row_update (g_ptr_array_index (self->connections_row, idx));
@@ -519,6 +651,12 @@ cc_wifi_connection_list_dispose (GObject *object)
   /* Drop all external references */
   clear_widget (self);
 
+  if (self->pending_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->pending_tick_id);
+      self->pending_tick_id = 0;
+    }
+
   G_OBJECT_CLASS (cc_wifi_connection_list_parent_class)->dispose (object);
 }
 
@@ -534,6 +672,9 @@ cc_wifi_connection_list_finalize (GObject *object)
   g_clear_pointer (&self->connections_row, g_ptr_array_unref);
   g_clear_pointer (&self->ssid_to_row, g_hash_table_unref);
   g_clear_pointer (&self->ap_ssid_cache, g_hash_table_unref);
+  g_clear_pointer (&self->connection_to_idx, g_hash_table_unref);
+  g_clear_pointer (&self->ap_to_rows, g_hash_table_unref);
+  g_clear_pointer (&self->pending_rows, g_hash_table_unref);
 
   G_OBJECT_CLASS (cc_wifi_connection_list_parent_class)->finalize (object);
 }
@@ -713,6 +854,11 @@ cc_wifi_connection_list_init (CcWifiConnectionList *self)
                                              (GDestroyNotify) g_bytes_unref, NULL);
   self->ap_ssid_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal,
                                                NULL, (GDestroyNotify) g_bytes_unref);
+  self->connection_to_idx = g_hash_table_new (g_direct_hash, g_direct_equal);
+  self->ap_to_rows = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                            NULL, (GDestroyNotify) g_ptr_array_unref);
+  self->pending_rows = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                              g_object_unref, NULL);
 }
 
 CcWifiConnectionList *
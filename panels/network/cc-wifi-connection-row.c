@@ -39,6 +39,12 @@ struct _CcWifiConnectionRow
   GtkImage        *encrypted_icon;
   GtkLabel        *name_label;
   GtkImage        *strength_icon;
+
+  /* Sort key, only updated together with the UI */
+  gboolean         sort_active;
+  guint8           sort_strength;
+  gchar           *sort_name;
+  gchar           *sort_collate_key;
 };
 
 enum
@@ -67,6 +73,9 @@ G_DEFINE_TYPE (CcWifiConnectionRow, cc_wifi_connection_row, GTK_TYPE_LIST_BOX_RO
 
 static GParamSpec *props[PROP_LAST];
 
+/* Minimal strength change (in percent) that affects the row order */
+#define STRENGTH_HYSTERESIS 5
+
 static void configure_clicked_cb (CcWifiConnectionRow *self);
 
 static NMAccessPointSecurity
@@ -151,11 +160,45 @@ get_connection_security (NMConnection *con)
     return NM_AP_SEC_UNKNOWN;
 }
 
+static gboolean
+update_sort_key (CcWifiConnectionRow *self,
+                 gboolean             active,
+                 guint8               strength,
+                 const gchar         *name)
+{
+  gboolean changed = FALSE;
+
+  /* Ignore small strength fluctuations so that rows do not keep swapping
+   * places; dropping to or rising from zero is always applied. */
+  if (ABS ((gint) strength - (gint) self->sort_strength) < STRENGTH_HYSTERESIS &&
+      strength != 0 && self->sort_strength != 0)
+    strength = self->sort_strength;
+
+  if (self->sort_active != active || self->sort_strength != strength)
+    {
+      self->sort_active = active;
+      self->sort_strength = strength;
+      changed = TRUE;
+    }
+
+  if (g_strcmp0 (self->sort_name, name) != 0)
+    {
+      g_free (self->sort_name);
+      g_free (self->sort_collate_key);
+      self->sort_name = g_strdup (name);
+      self->sort_collate_key = name ? g_utf8_collate_key (name, -1) : NULL;
+      changed = TRUE;
+    }
+
+  return changed;
+}
+
 static void
 update_ui (CcWifiConnectionRow *self)
 {
   GBytes *ssid;
   g_autofree gchar *title = NULL;
+  const gchar *sort_name;
   NMActiveConnection *active_connection = NULL;
   gboolean active;
   gboolean connecting;
@@ -189,6 +232,7 @@ update_ui (CcWifiConnectionRow *self)
       ssid = nm_setting_wireless_get_ssid (sw);
       ssid_str = nm_utils_ssid_to_utf8 (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid));
       name = nm_connection_get_id (NM_CONNECTION (self->connection));
+      sort_name = name;
 
       ssid_pos = strstr (name, ssid_str);
       if (ssid_pos == name && strlen (name) == strlen (ssid_str))
@@ -216,6 +260,7 @@ update_ui (CcWifiConnectionRow *self)
       ssid = nm_access_point_get_ssid (best_ap);
       title = nm_utils_ssid_to_utf8 (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid));
       gtk_label_set_text (self->name_label, title);
+      sort_name = title;
     }
 
   if (active_connection)
@@ -317,6 +362,10 @@ update_ui (CcWifiConnectionRow *self)
     {
       gtk_widget_set_child_visible (GTK_WIDGET (self->strength_icon), FALSE);
     }
+
+  /* Only resort the row if its position may have changed */
+  if (update_sort_key (self, active_connection != NULL, strength, sort_name))
+    gtk_list_box_row_changed (GTK_LIST_BOX_ROW (self));
 }
 
 static void
@@ -440,6 +489,8 @@ cc_wifi_connection_row_finalize (GObject *object)
   g_clear_object (&self->device);
   g_clear_pointer (&self->aps, g_ptr_array_unref);
   g_clear_object (&self->connection);
+  g_clear_pointer (&self->sort_name, g_free);
+  g_clear_pointer (&self->sort_collate_key, g_free);
 
   G_OBJECT_CLASS (cc_wifi_connection_row_parent_class)->finalize (object);
 }
@@ -667,8 +718,27 @@ void
 cc_wifi_connection_row_update (CcWifiConnectionRow *self)
 {
   update_ui (self);
+}
+
+/* Orders the active connection first, then configured networks, then
+ * networks by signal strength and name. Only uses the cached sort key. */
+gint
+cc_wifi_connection_row_compare (CcWifiConnectionRow *a,
+                                CcWifiConnectionRow *b)
+{
+  gboolean a_configured, b_configured;
+
+  if (a->sort_active != b->sort_active)
+    return a->sort_active ? -1 : 1;
+
+  a_configured = a->connection != NULL;
+  b_configured = b->connection != NULL;
+  if (a_configured != b_configured)
+    return a_configured ? -1 : 1;
 
-  gtk_list_box_row_changed (GTK_LIST_BOX_ROW (self));
+  if (a->sort_strength != b->sort_strength)
+    return a->sort_strength > b->sort_strength ? -1 : 1;
 
+  return g_strcmp0 (a->sort_collate_key, b->sort_collate_key);
 }
 
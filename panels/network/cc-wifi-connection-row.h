@@ -50,4 +50,6 @@ gboolean             cc_wifi_connection_row_has_access_point    (CcWifiConnectio
                                                                  NMAccessPoint         *ap);
 
 void                 cc_wifi_connection_row_update              (CcWifiConnectionRow   *row);
+gint                 cc_wifi_connection_row_compare             (CcWifiConnectionRow   *a,
+                                                                 CcWifiConnectionRow   *b);
 G_END_DECLS
@@ -43,6 +43,7 @@
 #include "cc-wifi-connection-row.h"
 
 #define PERIODIC_WIFI_SCAN_TIMEOUT 15
+#define PERIODIC_WIFI_SCAN_TIMEOUT_MAX 120
 
 static void nm_device_wifi_refresh_ui (NetDeviceWifi *self);
 static void show_wifi_list (NetDeviceWifi *self);
@@ -78,8 +79,10 @@ struct _NetDeviceWifi
         gint64                   last_scan;
         gboolean                 scanning;
 
-        guint                    monitor_scanning_id;
+        /* The scan interval doubles while the set of APs stays the same */
         guint                    scan_id;
+        guint                    scan_interval;
+        gboolean                 aps_changed;
         GCancellable            *cancellable;
 };
 
@@ -95,10 +98,6 @@ static void
 disable_scan_timeout (NetDeviceWifi *self)
 {
         g_debug ("Disabling periodic Wi-Fi scan");
-        if (self->monitor_scanning_id > 0) {
-                g_source_remove (self->monitor_scanning_id);
-                self->monitor_scanning_id = 0;
-        }
         if (self->scan_id > 0) {
                 g_source_remove (self->scan_id);
                 self->scan_id = 0;
@@ -297,45 +296,101 @@ set_scanning (NetDeviceWifi *self,
                 g_object_notify (G_OBJECT (self), "scanning");
 }
 
-static gboolean
-update_scanning (gpointer user_data)
+static gboolean scan_timeout_cb (gpointer user_data);
+
+static void
+schedule_scan (NetDeviceWifi *self)
+{
+        if (self->scan_id > 0)
+                g_source_remove (self->scan_id);
+        self->scan_id = g_timeout_add_seconds (self->scan_interval, scan_timeout_cb, self);
+}
+
+static void
+request_scan_cb (GObject      *source_object,
+                 GAsyncResult *res,
+                 gpointer      user_data)
 {
         NetDeviceWifi *self = user_data;
-        gint64 last_scan;
+        g_autoptr(GError) error = NULL;
 
-        last_scan = nm_device_wifi_get_last_scan (NM_DEVICE_WIFI (self->device));
+        if (nm_device_wifi_request_scan_finish (NM_DEVICE_WIFI (source_object), res, &error))
+                return;
 
-        /* The last_scan property is updated after the device finished scanning,
-         * so notify about it and stop monitoring for changes.
-         */
-        if (self->last_scan != last_scan) {
-                set_scanning (self, FALSE, last_scan);
-                self->monitor_scanning_id = 0;
-                return G_SOURCE_REMOVE;
-        }
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                return;
+
+        /* LastScan will not change, so don't wait for it */
+        g_debug ("Wi-Fi scan request failed: %s", error->message);
+        set_scanning (self, FALSE, self->last_scan);
+}
+
+static void
+request_scan (NetDeviceWifi *self)
+{
+        g_debug ("Periodic Wi-Fi scan requested");
+
+        set_scanning (self, TRUE,
+                      nm_device_wifi_get_last_scan (NM_DEVICE_WIFI (self->device)));
 
-        return G_SOURCE_CONTINUE;
+        nm_device_wifi_request_scan_async (NM_DEVICE_WIFI (self->device),
+                                           self->cancellable, request_scan_cb, self);
+
+        /* Normally rescheduled once LastScan changes; this is the fallback
+         * in case NetworkManager decides not to scan. */
+        schedule_scan (self);
 }
 
 static gboolean
-request_scan (gpointer user_data)
+scan_timeout_cb (gpointer user_data)
 {
         NetDeviceWifi *self = user_data;
 
-        g_debug ("Periodic Wi-Fi scan requested");
+        self->scan_id = 0;
+        request_scan (self);
 
-        set_scanning (self, TRUE,
+        return G_SOURCE_REMOVE;
+}
+
+static void
+enable_scan_timeout (NetDeviceWifi *self)
+{
+        if (self->scan_id > 0 ||
+            !gtk_widget_get_mapped (GTK_WIDGET (self)) ||
+            !nm_client_wireless_get_enabled (self->client) ||
+            device_is_hotspot (self))
+                return;
+
+        self->scan_interval = PERIODIC_WIFI_SCAN_TIMEOUT;
+        request_scan (self);
+}
+
+static void
+on_last_scan_changed_cb (NetDeviceWifi *self)
+{
+        /* The last_scan property is updated after the device finished scanning,
+         * by us or anyone else.
+         */
+        set_scanning (self, FALSE,
                       nm_device_wifi_get_last_scan (NM_DEVICE_WIFI (self->device)));
 
-        if (self->monitor_scanning_id == 0) {
-                self->monitor_scanning_id = g_timeout_add (1500, update_scanning,
-                                                                  self);
-        }
+        if (self->scan_id == 0)
+                return;
 
-        nm_device_wifi_request_scan_async (NM_DEVICE_WIFI (self->device),
-                                           self->cancellable, NULL, NULL);
+        /* Scan less often while nothing changes around us */
+        if (self->aps_changed)
+                self->scan_interval = PERIODIC_WIFI_SCAN_TIMEOUT;
+        else
+                self->scan_interval = MIN (self->scan_interval * 2, PERIODIC_WIFI_SCAN_TIMEOUT_MAX);
+        self->aps_changed = FALSE;
+
+        schedule_scan (self);
+}
 
-        return G_SOURCE_CONTINUE;
+static void
+on_access_points_changed_cb (NetDeviceWifi *self)
+{
+        self->aps_changed = TRUE;
 }
 
 static void
@@ -350,12 +405,7 @@ nm_device_wifi_refresh_ui (NetDeviceWifi *self)
                 return;
         }
 
-        if (self->scan_id == 0 &&
-            nm_client_wireless_get_enabled (self->client)) {
-                self->scan_id = g_timeout_add_seconds (PERIODIC_WIFI_SCAN_TIMEOUT,
-                                                       request_scan, self);
-                request_scan (self);
-        }
+        enable_scan_timeout (self);
 
         /* keep this in sync with the signal handler setup in cc_network_panel_init */
         wireless_enabled_toggled (self);
@@ -915,51 +965,10 @@ history_sort (gconstpointer a, gconstpointer b, gpointer data)
 static gint
 ap_sort (gconstpointer a, gconstpointer b, gpointer data)
 {
-        NetDeviceWifi *self = data;
-        CcWifiConnectionRow *a_row = CC_WIFI_CONNECTION_ROW ((gpointer) a);
-        CcWifiConnectionRow *b_row = CC_WIFI_CONNECTION_ROW ((gpointer) b);
-        NMActiveConnection *active_connection;
-        gboolean a_configured, b_configured;
-        NMAccessPoint *apa, *apb;
-        guint sa, sb;
-
-        /* Show the connected AP first */
-        active_connection = nm_device_get_active_connection (NM_DEVICE (self->device));
-        if (active_connection != NULL) {
-                NMConnection *connection = NM_CONNECTION (nm_active_connection_get_connection (active_connection));
-                if (connection == cc_wifi_connection_row_get_connection (a_row))
-                        return -1;
-                else if (connection == cc_wifi_connection_row_get_connection (b_row))
-                        return 1;
-        }
-
-        /* Show configured networks before non-configured */
-        a_configured = cc_wifi_connection_row_get_connection (a_row) != NULL;
-        b_configured = cc_wifi_connection_row_get_connection (b_row) != NULL;
-        if (a_configured != b_configured) {
-                if (a_configured) return -1;
-                if (b_configured) return 1;
-        }
-
-        /* Show higher strength networks above lower strength ones */
-
-        apa = cc_wifi_connection_row_best_access_point (a_row);
-        apb = cc_wifi_connection_row_best_access_point (b_row);
-
-        if (apa)
-                sa = nm_access_point_get_strength (apa);
-        else
-                sa = 0;
-
-        if (apb)
-                sb = nm_access_point_get_strength (apb);
-        else
-                sb = 0;
-
-        if (sa > sb) return -1;
-        if (sb > sa) return 1;
-
-        return 0;
+        /* The rows cache their sort key, so that resorting does not need
+         * to query the device and access points for every comparison */
+        return cc_wifi_connection_row_compare (CC_WIFI_CONNECTION_ROW ((gpointer) a),
+                                               CC_WIFI_CONNECTION_ROW ((gpointer) b));
 }
 
 static void
@@ -1152,6 +1161,27 @@ ap_activated (NetDeviceWifi *self, GtkListBoxRow *row)
         }
 }
 
+static void
+net_device_wifi_map (GtkWidget *widget)
+{
+        NetDeviceWifi *self = NET_DEVICE_WIFI (widget);
+
+        GTK_WIDGET_CLASS (net_device_wifi_parent_class)->map (widget);
+
+        enable_scan_timeout (self);
+}
+
+static void
+net_device_wifi_unmap (GtkWidget *widget)
+{
+        NetDeviceWifi *self = NET_DEVICE_WIFI (widget);
+
+        /* Nobody sees the list, so don't waste power on scanning */
+        disable_scan_timeout (self);
+
+        GTK_WIDGET_CLASS (net_device_wifi_parent_class)->unmap (widget);
+}
+
 static void
 net_device_wifi_class_init (NetDeviceWifiClass *klass)
 {
@@ -1161,6 +1191,9 @@ net_device_wifi_class_init (NetDeviceWifiClass *klass)
         object_class->finalize = net_device_wifi_finalize;
         object_class->get_property = net_device_wifi_get_property;
 
+        widget_class->map = net_device_wifi_map;
+        widget_class->unmap = net_device_wifi_unmap;
+
         g_object_class_install_property (object_class,
                                          PROP_SCANNING,
                                          g_param_spec_boolean ("scanning",
@@ -1239,6 +1272,12 @@ net_device_wifi_new (CcPanel *panel, NMClient *client, NMDevice *device)
                                  G_CALLBACK (wireless_enabled_toggled), self, G_CONNECT_SWAPPED);
 
         g_signal_connect_object (device, "state-changed", G_CALLBACK (nm_device_wifi_refresh_ui), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (device, "notify::" NM_DEVICE_WIFI_LAST_SCAN,
+                                 G_CALLBACK (on_last_scan_changed_cb), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (device, "access-point-added",
+                                 G_CALLBACK (on_access_points_changed_cb), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (device, "access-point-removed",
+                                 G_CALLBACK (on_access_points_changed_cb), self, G_CONNECT_SWAPPED);
 
         list = GTK_WIDGET (cc_wifi_connection_list_new (client, NM_DEVICE_WIFI (device), TRUE, TRUE, FALSE));
         gtk_widget_show (list);
@@ -793,6 +793,37 @@ destroy_nonexisting_entries (PpPrinterEntry *entry,
     }
 }
 
+static void
+get_jobs_counts_cb (GObject      *source_object,
+                    GAsyncResult *result,
+                    gpointer      user_data)
+{
+  CcPrintersPanel        *self = (CcPrintersPanel*) user_data;
+  g_autoptr(GHashTable)   counts = NULL;
+  g_autoptr(GError)       error = NULL;
+  GHashTableIter          iter;
+  gpointer                key, value;
+
+  counts = pp_cups_get_jobs_counts_finish (PP_CUPS (source_object), result, &error);
+
+  if (counts == NULL)
+    {
+      if (error != NULL && !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_warning ("Could not get jobs: %s", error->message);
+        }
+
+      return;
+    }
+
+  g_hash_table_iter_init (&iter, self->printer_entries);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      pp_printer_entry_set_jobs_count (PP_PRINTER_ENTRY (value),
+                                       GPOINTER_TO_UINT (g_hash_table_lookup (counts, key)));
+    }
+}
+
 static void
 actualize_printers_list_cb (GObject      *source_object,
                             GAsyncResult *result,
@@ -851,6 +882,15 @@ actualize_printers_list_cb (GObject      *source_object,
         add_printer_entry (self, self->dests[i]);
     }
 
+  /* Jobs of all printers are counted by one request
+   * and the results are distributed to the entries */
+  pp_cups_get_jobs_counts_async (PP_CUPS (source_object),
+                                 TRUE,
+                                 CUPS_WHICHJOBS_ACTIVE,
+                                 cc_panel_get_cancellable (CC_PANEL (self)),
+                                 get_jobs_counts_cb,
+                                 self);
+
   if (!self->entries_filled)
     {
       if (self->action != NULL)
@@ -104,6 +104,86 @@ pp_cups_get_dests_finish (PpCups        *self,
   return g_task_propagate_pointer (G_TASK (res), error);
 }
 
+typedef struct
+{
+  gboolean myjobs;
+  gint     which_jobs;
+} GetJobsCountsData;
+
+/* Fetches jobs of all printers with a single Get-Jobs request
+ * and counts them per destination */
+static void
+get_jobs_counts_thread (GTask        *task,
+                        gpointer      source_object,
+                        gpointer      task_data,
+                        GCancellable *cancellable)
+{
+  GetJobsCountsData *data = task_data;
+  cups_job_t        *jobs = NULL;
+  GHashTable        *counts;
+  gint               num_jobs;
+  gint               i;
+
+  num_jobs = cupsGetJobs (&jobs,
+                          NULL,
+                          data->myjobs ? 1 : 0,
+                          data->which_jobs);
+
+  counts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  for (i = 0; i < num_jobs; i++)
+    {
+      guint count;
+
+      if (jobs[i].dest == NULL)
+        continue;
+
+      count = GPOINTER_TO_UINT (g_hash_table_lookup (counts, jobs[i].dest));
+      g_hash_table_insert (counts, g_strdup (jobs[i].dest), GUINT_TO_POINTER (count + 1));
+    }
+
+  cupsFreeJobs (num_jobs, jobs);
+
+  if (g_task_set_return_on_cancel (task, FALSE))
+    {
+      g_task_return_pointer (task, counts, (GDestroyNotify) g_hash_table_unref);
+    }
+  else
+    {
+      g_hash_table_unref (counts);
+    }
+}
+
+void
+pp_cups_get_jobs_counts_async (PpCups              *self,
+                               gboolean             myjobs,
+                               gint                 which_jobs,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  GetJobsCountsData *data;
+  g_autoptr(GTask) task = NULL;
+
+  data = g_new (GetJobsCountsData, 1);
+  data->myjobs = myjobs;
+  data->which_jobs = which_jobs;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_task_data (task, data, g_free);
+  g_task_set_return_on_cancel (task, TRUE);
+  g_task_run_in_thread (task, get_jobs_counts_thread);
+}
+
+GHashTable *
+pp_cups_get_jobs_counts_finish (PpCups        *self,
+                                GAsyncResult  *result,
+                                GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 static void
 connection_test_thread (GTask        *task,
                         gpointer      source_object,
@@ -45,6 +45,17 @@ PpCupsDests *pp_cups_get_dests_finish (PpCups               *cups,
                                        GAsyncResult         *result,
                                        GError              **error);
 
+void         pp_cups_get_jobs_counts_async  (PpCups              *cups,
+                                             gboolean             myjobs,
+                                             gint                 which_jobs,
+                                             GCancellable        *cancellable,
+                                             GAsyncReadyCallback  callback,
+                                             gpointer             user_data);
+
+GHashTable  *pp_cups_get_jobs_counts_finish (PpCups              *cups,
+                                             GAsyncResult        *result,
+                                             GError             **error);
+
 void         pp_cups_connection_test_async (PpCups              *cups,
                                             GCancellable        *cancellable,
                                             GAsyncReadyCallback  callback,
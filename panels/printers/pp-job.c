@@ -80,6 +80,13 @@ pp_job_new (gint id, const gchar *title, gint state, GStrv auth_info_required)
    return job;
 }
 
+gint
+pp_job_get_id (PpJob *self)
+{
+   g_return_val_if_fail (PP_IS_JOB(self), -1);
+   return self->id;
+}
+
 const gchar *
 pp_job_get_title (PpJob *self)
 {
@@ -72,6 +72,7 @@ struct _PpJobsDialog {
   gboolean   pop_up_authentication_popup;
 
   GCancellable *get_jobs_cancellable;
+  gboolean      update_pending;
 };
 
 G_DEFINE_TYPE (PpJobsDialog, pp_jobs_dialog, GTK_TYPE_DIALOG)
@@ -189,6 +190,100 @@ pop_up_authentication_popup (PpJobsDialog *self)
     gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (self->authenticate_jobs_button), TRUE);
 }
 
+static void update_jobs_list (PpJobsDialog *self);
+
+static gboolean
+auth_info_equal (GStrv a,
+                 GStrv b)
+{
+  gint i;
+
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  for (i = 0; a[i] != NULL && b[i] != NULL; i++)
+    if (g_strcmp0 (a[i], b[i]) != 0)
+      return FALSE;
+
+  return a[i] == NULL && b[i] == NULL;
+}
+
+static gboolean
+job_equal (PpJob *a,
+           PpJob *b)
+{
+  return pp_job_get_state (a) == pp_job_get_state (b) &&
+         g_strcmp0 (pp_job_get_title (a), pp_job_get_title (b)) == 0 &&
+         auth_info_equal (pp_job_get_auth_info_required (a),
+                          pp_job_get_auth_info_required (b));
+}
+
+/* Brings the store in line with the given jobs so that only rows
+ * of added, removed or changed jobs are recreated */
+static void
+jobs_store_update (PpJobsDialog *self,
+                   GPtrArray    *jobs)
+{
+  g_autoptr(GHashTable) new_ids = NULL;
+  g_autoptr(GHashTable) old_ids = NULL;
+  GListModel *model = G_LIST_MODEL (self->store);
+  guint       n_items;
+  guint       i, j;
+
+  new_ids = g_hash_table_new (g_direct_hash, g_direct_equal);
+  for (i = 0; i < jobs->len; i++)
+    g_hash_table_add (new_ids, GINT_TO_POINTER (pp_job_get_id (g_ptr_array_index (jobs, i))));
+
+  old_ids = g_hash_table_new (g_direct_hash, g_direct_equal);
+  n_items = g_list_model_get_n_items (model);
+  for (i = n_items; i > 0; i--)
+    {
+      g_autoptr(PpJob) job = g_list_model_get_item (model, i - 1);
+      gint             id = pp_job_get_id (job);
+
+      if (g_hash_table_contains (new_ids, GINT_TO_POINTER (id)))
+        g_hash_table_add (old_ids, GINT_TO_POINTER (id));
+      else
+        g_list_store_remove (self->store, i - 1);
+    }
+
+  for (i = 0; i < jobs->len; i++)
+    {
+      PpJob           *job = g_ptr_array_index (jobs, i);
+      g_autoptr(PpJob) old_job = NULL;
+      gint             id = pp_job_get_id (job);
+
+      if (i < g_list_model_get_n_items (model))
+        old_job = g_list_model_get_item (model, i);
+
+      if (old_job != NULL && pp_job_get_id (old_job) == id)
+        {
+          if (!job_equal (old_job, job))
+            g_list_store_splice (self->store, i, 1, (gpointer *) &job, 1);
+
+          continue;
+        }
+
+      if (g_hash_table_contains (old_ids, GINT_TO_POINTER (id)))
+        {
+          /* The job moved in the queue */
+          n_items = g_list_model_get_n_items (model);
+          for (j = i + 1; j < n_items; j++)
+            {
+              g_autoptr(PpJob) moved_job = g_list_model_get_item (model, j);
+
+              if (pp_job_get_id (moved_job) == id)
+                {
+                  g_list_store_remove (self->store, j);
+                  break;
+                }
+            }
+        }
+
+      g_list_store_insert (self->store, i, job);
+    }
+}
+
 static void
 update_jobs_list_cb (GObject      *source_object,
                      GAsyncResult *result,
@@ -202,19 +297,27 @@ update_jobs_list_cb (GObject      *source_object,
   gint                 num_of_auth_jobs = 0;
   guint                i;
 
-  g_list_store_remove_all (self->store);
-
   jobs = pp_printer_get_jobs_finish (printer, result, &error);
   if (error != NULL)
     {
       if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
         {
           g_warning ("Could not get jobs: %s", error->message);
+          g_clear_object (&self->get_jobs_cancellable);
+
+          /* Don't lose notifications that arrived during the failed request */
+          if (self->update_pending)
+            {
+              self->update_pending = FALSE;
+              update_jobs_list (self);
+            }
         }
 
       return;
     }
 
+  jobs_store_update (self, jobs);
+
   if (jobs->len > 0)
     {
       gtk_widget_set_sensitive (GTK_WIDGET (self->jobs_clear_all_button), TRUE);
@@ -230,8 +333,6 @@ update_jobs_list_cb (GObject      *source_object,
     {
       job = PP_JOB (g_ptr_array_index (jobs, i));
 
-      g_list_store_append (self->store, g_object_ref (job));
-
       if (pp_job_get_auth_info_required (job) != NULL)
         {
           num_of_auth_jobs++;
@@ -260,6 +361,13 @@ update_jobs_list_cb (GObject      *source_object,
 
   g_clear_object (&self->get_jobs_cancellable);
 
+  /* Notifications arrived while the jobs were being fetched */
+  if (self->update_pending)
+    {
+      self->update_pending = FALSE;
+      update_jobs_list (self);
+    }
+
   if (!self->jobs_filled)
     {
       if (self->pop_up_authentication_popup)
@@ -279,8 +387,12 @@ update_jobs_list (PpJobsDialog *self)
 
   if (self->printer_name != NULL)
     {
-      g_cancellable_cancel (self->get_jobs_cancellable);
-      g_clear_object (&self->get_jobs_cancellable);
+      /* Coalesce updates requested while a request is in flight */
+      if (self->get_jobs_cancellable != NULL)
+        {
+          self->update_pending = TRUE;
+          return;
+        }
 
       self->get_jobs_cancellable = g_cancellable_new ();
 
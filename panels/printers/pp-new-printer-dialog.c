@@ -95,6 +95,9 @@ struct _PpNewPrinterDialog
 
   GPtrArray *local_cups_devices;
 
+  /* Original names of listed devices and names of existing printers */
+  DeviceNames *device_names;
+
   GtkListStore       *store;
   GtkTreeModelFilter *filter;
   GtkTreeView        *treeview;
@@ -482,6 +485,7 @@ pp_new_printer_dialog_init (PpNewPrinterDialog *self)
     }
 
   self->local_cups_devices = g_ptr_array_new_with_free_func (g_object_unref);
+  self->device_names = device_names_new ();
 
   /* GCancellable for cancelling of async operations */
   self->cancellable = g_cancellable_new ();
@@ -539,6 +543,7 @@ pp_new_printer_dialog_finalize (GObject *object)
   g_clear_pointer (&self->list, ppd_list_free);
   g_clear_object (&self->builder);
   g_clear_pointer (&self->local_cups_devices, g_ptr_array_unref);
+  g_clear_pointer (&self->device_names, device_names_free);
   g_clear_object (&self->new_device);
   g_clear_object (&self->local_printer_icon);
   g_clear_object (&self->remote_printer_icon);
@@ -612,6 +617,7 @@ remove_device_from_list (PpNewPrinterDialog *self,
 
       if (g_strcmp0 (pp_print_device_get_device_name (device), device_name) == 0)
         {
+          device_names_remove (self->device_names, pp_print_device_get_device_original_name (device));
           gtk_list_store_remove (self->store, &iter);
           break;
         }
@@ -622,29 +628,10 @@ remove_device_from_list (PpNewPrinterDialog *self,
   update_dialog_state (self);
 }
 
-static gboolean
-prepend_original_name (GtkTreeModel *model,
-                       GtkTreePath  *path,
-                       GtkTreeIter  *iter,
-                       gpointer      data)
-{
-  g_autoptr(PpPrintDevice) device = NULL;
-  GList         **list = data;
-
-  gtk_tree_model_get (model, iter,
-                      DEVICE_COLUMN, &device,
-                      -1);
-
-  *list = g_list_prepend (*list, g_strdup (pp_print_device_get_device_original_name (device)));
-
-  return FALSE;
-}
-
 static void
 add_device_to_list (PpNewPrinterDialog *self,
                     PpPrintDevice      *device)
 {
-  GList                     *original_names_list = NULL;
   gint                       acquisition_method;
 
   if (device)
@@ -672,19 +659,7 @@ add_device_to_list (PpNewPrinterDialog *self,
                         "device-original-name", pp_print_device_get_device_name (device),
                         NULL);
 
-          gtk_tree_model_foreach (GTK_TREE_MODEL (self->store),
-                                  prepend_original_name,
-                                  &original_names_list);
-
-          original_names_list = g_list_reverse (original_names_list);
-
-          canonicalized_name = canonicalize_device_name (original_names_list,
-                                                         self->local_cups_devices,
-                                                         self->dests,
-                                                         self->num_of_dests,
-                                                         device);
-
-          g_list_free_full (original_names_list, g_free);
+          canonicalized_name = canonicalize_device_name (self->device_names, device);
 
           g_object_set (device,
                         "display-name", canonicalized_name,
@@ -692,7 +667,10 @@ add_device_to_list (PpNewPrinterDialog *self,
                         NULL);
 
           if (pp_print_device_get_acquisition_method (device) == ACQUISITION_METHOD_DEFAULT_CUPS_SERVER)
-            g_ptr_array_add (self->local_cups_devices, g_object_ref (device));
+            {
+              g_ptr_array_add (self->local_cups_devices, g_object_ref (device));
+              device_names_add (self->device_names, pp_print_device_get_device_original_name (device));
+            }
           else
             set_device (self, device, NULL);
         }
@@ -852,7 +830,12 @@ group_physical_devices_cb (gchar    ***device_uris,
   else
     {
       for (i = 0; i < self->local_cups_devices->len; i++)
-        set_device (self, g_ptr_array_index (self->local_cups_devices, i), NULL);
+        {
+          PpPrintDevice *device = g_ptr_array_index (self->local_cups_devices, i);
+
+          device_names_remove (self->device_names, pp_print_device_get_device_original_name (device));
+          set_device (self, device, NULL);
+        }
       g_ptr_array_set_size (self->local_cups_devices, 0);
     }
 
@@ -1478,6 +1461,7 @@ search_address (const gchar        *text,
               acquisition_method == ACQUISITION_METHOD_LPD ||
               acquisition_method == ACQUISITION_METHOD_SAMBA_HOST)
             {
+              device_names_remove (self->device_names, pp_print_device_get_device_original_name (device));
               if (!gtk_list_store_remove (self->store, &iter))
                 break;
               else
@@ -1599,6 +1583,21 @@ get_local_scheme_description_from_uri (gchar *device_uri)
   return description;
 }
 
+/* Releases the name of the device which is about to be replaced */
+static void
+forget_device_name (PpNewPrinterDialog *self,
+                    GtkTreeIter        *iter)
+{
+  g_autoptr(PpPrintDevice) device = NULL;
+
+  gtk_tree_model_get (GTK_TREE_MODEL (self->store), iter,
+                      DEVICE_COLUMN, &device,
+                      -1);
+
+  if (device != NULL)
+    device_names_remove (self->device_names, pp_print_device_get_device_original_name (device));
+}
+
 static void
 set_device (PpNewPrinterDialog *self,
             PpPrintDevice      *device,
@@ -1640,6 +1639,8 @@ set_device (PpNewPrinterDialog *self,
 
           if (iter == NULL)
             gtk_list_store_append (self->store, &titer);
+          else
+            forget_device_name (self, iter);
 
           gtk_list_store_set (self->store, iter == NULL ? &titer : iter,
                               DEVICE_GICON_COLUMN, pp_print_device_is_network_device (device) ? self->remote_printer_icon : self->local_printer_icon,
@@ -1649,12 +1650,16 @@ set_device (PpNewPrinterDialog *self,
                               DEVICE_VISIBLE_COLUMN, TRUE,
                               DEVICE_COLUMN, device,
                               -1);
+
+          device_names_add (self->device_names, pp_print_device_get_device_original_name (device));
         }
       else if (pp_print_device_is_authenticated_server (device) &&
                pp_print_device_get_host_name (device) != NULL)
         {
           if (iter == NULL)
             gtk_list_store_append (self->store, &titer);
+          else
+            forget_device_name (self, iter);
 
           gtk_list_store_set (self->store, iter == NULL ? &titer : iter,
                               DEVICE_GICON_COLUMN, self->authenticated_server_icon,
@@ -1666,6 +1671,8 @@ set_device (PpNewPrinterDialog *self,
                               DEVICE_VISIBLE_COLUMN, TRUE,
                               DEVICE_COLUMN, device,
                               -1);
+
+          device_names_add (self->device_names, pp_print_device_get_device_original_name (device));
         }
     }
 }
@@ -1716,6 +1723,9 @@ cups_get_dests_cb (GObject      *source_object,
       self->dests = dests->dests;
       self->num_of_dests = dests->num_of_dests;
 
+      for (gint i = 0; i < self->num_of_dests; i++)
+        device_names_add (self->device_names, self->dests[i].name);
+
       get_cups_devices (self);
     }
   else
@@ -1895,7 +1905,6 @@ ppd_selection_cb (GtkDialog *_dialog,
 {
   PpNewPrinterDialog        *self = user_data;
   g_autoptr(PpNewPrinter)    new_printer = NULL;
-  GList                     *original_names_list = NULL;
   g_autofree gchar          *ppd_name = NULL;
   g_autofree gchar          *ppd_display_name = NULL;
   guint                      window_id = 0;
@@ -1925,19 +1934,7 @@ ppd_selection_cb (GtkDialog *_dialog,
                         "device-original-name", ppd_display_name,
                         NULL);
 
-          gtk_tree_model_foreach (GTK_TREE_MODEL (self->store),
-                                  prepend_original_name,
-                                  &original_names_list);
-
-          original_names_list = g_list_reverse (original_names_list);
-
-          printer_name = canonicalize_device_name (original_names_list,
-                                                   self->local_cups_devices,
-                                                   self->dests,
-                                                   self->num_of_dests,
-                                                   self->new_device);
-
-          g_list_free_full (original_names_list, g_free);
+          printer_name = canonicalize_device_name (self->device_names, self->new_device);
 
           g_object_set (self->new_device,
                         "device-name", printer_name,
@@ -61,11 +61,23 @@ struct _PpOptionsDialog {
   GHashTable  *ipp_attributes;
   gboolean     ipp_attributes_set;
 
+  /* Parsed PPD whose options are turned into widgets tab by tab */
+  ppd_file_t  *ppd_file;
+  GPtrArray   *tabs;
+
   gboolean sensitive;
 };
 
 G_DEFINE_TYPE (PpOptionsDialog, pp_options_dialog, GTK_TYPE_DIALOG)
 
+typedef struct
+{
+  GtkWidget *grid;
+  gint       n_rows;
+  /* PPD options of this tab whose widgets were not created yet */
+  GPtrArray *ppd_options;
+} OptionsTab;
+
 enum
 {
   CATEGORY_IDS_COLUMN = 0,
@@ -292,47 +304,62 @@ ppd_option_name_translate (ppd_option_t *option)
   return option->text;
 }
 
-static gint
-grid_get_height (GtkWidget *grid)
+static OptionsTab *
+options_tab_new (void)
 {
-  GList *children;
-  GList *child;
-  gint   height = 0;
-  gint   top_attach = 0;
-  gint   max = 0;
-
-  children = gtk_container_get_children (GTK_CONTAINER (grid));
-  for (child = children; child; child = g_list_next (child))
-    {
-      gtk_container_child_get (GTK_CONTAINER (grid), child->data,
-                               "top-attach", &top_attach,
-                               "height", &height,
-                               NULL);
+  OptionsTab *tab;
 
-      if (height + top_attach > max)
-        max = height + top_attach;
-    }
+  tab = g_slice_new0 (OptionsTab);
+  tab->grid = gtk_grid_new ();
+  g_object_ref_sink (tab->grid);
+  gtk_widget_show (tab->grid);
+  gtk_container_set_border_width (GTK_CONTAINER (tab->grid), 20);
+  gtk_grid_set_row_spacing (GTK_GRID (tab->grid), 15);
+  tab->ppd_options = g_ptr_array_new ();
 
-  g_list_free (children);
+  return tab;
+}
 
-  return max;
+static void
+options_tab_free (OptionsTab *tab)
+{
+  g_clear_object (&tab->grid);
+  g_clear_pointer (&tab->ppd_options, g_ptr_array_unref);
+  g_slice_free (OptionsTab, tab);
 }
 
 static gboolean
-grid_is_empty (GtkWidget *grid)
+options_tab_is_empty (OptionsTab *tab)
 {
-  GList *children;
+  return tab->n_rows == 0 && tab->ppd_options->len == 0;
+}
 
-  children = gtk_container_get_children (GTK_CONTAINER (grid));
-  if (children)
-    {
-      g_list_free (children);
-      return FALSE;
-    }
-  else
-    {
-      return TRUE;
-    }
+static void
+option_row_add (OptionsTab  *tab,
+                GtkWidget   *widget,
+                const gchar *option_display_name,
+                gboolean     sensitive)
+{
+  GtkStyleContext *context;
+  GtkWidget       *label;
+
+  gtk_widget_show (widget);
+  gtk_widget_set_sensitive (widget, sensitive);
+
+  label = gtk_label_new (option_display_name);
+  gtk_widget_show (GTK_WIDGET (label));
+  gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
+  context = gtk_widget_get_style_context (label);
+  gtk_style_context_add_class (context, "dim-label");
+  gtk_widget_set_halign (label, GTK_ALIGN_END);
+  gtk_widget_set_valign (label, GTK_ALIGN_CENTER);
+  gtk_widget_set_margin_start (label, 10);
+  gtk_grid_attach (GTK_GRID (tab->grid), label, 0, tab->n_rows, 1, 1);
+
+  gtk_widget_set_margin_start (widget, 20);
+  gtk_grid_attach (GTK_GRID (tab->grid), widget, 1, tab->n_rows, 1, 1);
+
+  tab->n_rows++;
 }
 
 static GtkWidget *
@@ -341,93 +368,56 @@ ipp_option_add (IPPAttribute *attr_supported,
                 const gchar  *option_name,
                 const gchar  *option_display_name,
                 const gchar  *printer_name,
-                GtkWidget    *grid,
+                OptionsTab   *tab,
                 gboolean      sensitive)
 {
-  GtkStyleContext *context;
-  GtkWidget       *widget;
-  GtkWidget       *label;
-  gint             position;
+  GtkWidget *widget;
 
   widget = (GtkWidget *) pp_ipp_option_widget_new (attr_supported,
                                                    attr_default,
                                                    option_name,
                                                    printer_name);
   if (widget)
-    {
-      gtk_widget_show (widget);
-      gtk_widget_set_sensitive (widget, sensitive);
-      position = grid_get_height (grid);
-
-      label = gtk_label_new (option_display_name);
-      gtk_widget_show (GTK_WIDGET (label));
-      gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-      context = gtk_widget_get_style_context (label);
-      gtk_style_context_add_class (context, "dim-label");
-      gtk_widget_set_halign (label, GTK_ALIGN_END);
-      gtk_widget_set_valign (label, GTK_ALIGN_CENTER);
-      gtk_widget_set_margin_start (label, 10);
-      gtk_grid_attach (GTK_GRID (grid), label, 0, position, 1, 1);
-
-      gtk_widget_set_margin_start (widget, 20);
-      gtk_grid_attach (GTK_GRID (grid), widget, 1, position, 1, 1);
-    }
+    option_row_add (tab, widget, option_display_name, sensitive);
 
   return widget;
 }
 
 static GtkWidget *
-ppd_option_add (ppd_option_t  option,
+ppd_option_add (ppd_option_t *option,
                 const gchar  *printer_name,
-                GtkWidget    *grid,
+                OptionsTab   *tab,
                 gboolean      sensitive)
 {
-  GtkStyleContext *context;
-  GtkWidget       *widget;
-  GtkWidget       *label;
-  gint             position;
+  GtkWidget *widget;
 
-  widget = (GtkWidget *) pp_ppd_option_widget_new (&option, printer_name);
+  widget = (GtkWidget *) pp_ppd_option_widget_new (option, printer_name);
   if (widget)
-    {
-      gtk_widget_show (widget);
-      gtk_widget_set_sensitive (widget, sensitive);
-      position = grid_get_height (grid);
-
-      label = gtk_label_new (ppd_option_name_translate (&option));
-      gtk_widget_show (GTK_WIDGET (label));
-      gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-      context = gtk_widget_get_style_context (label);
-      gtk_style_context_add_class (context, "dim-label");
-      gtk_widget_set_halign (label, GTK_ALIGN_END);
-      gtk_widget_set_valign (label, GTK_ALIGN_CENTER);
-      gtk_widget_set_margin_start (label, 10);
-      gtk_grid_attach (GTK_GRID (grid), label, 0, position, 1, 1);
-
-      gtk_widget_set_margin_start (widget, 20);
-      gtk_grid_attach (GTK_GRID (grid), widget, 1, position, 1, 1);
-    }
+    option_row_add (tab, widget, ppd_option_name_translate (option), sensitive);
 
   return widget;
 }
 
-static GtkWidget *
-tab_grid_new ()
+/* Widgets of PPD options are created when their tab is shown for the first time */
+static void
+tab_populate (PpOptionsDialog *self,
+              OptionsTab      *tab)
 {
-  GtkWidget *grid;
+  guint i;
 
-  grid = gtk_grid_new ();
-  gtk_widget_show (GTK_WIDGET (grid));
-  gtk_container_set_border_width (GTK_CONTAINER (grid), 20);
-  gtk_grid_set_row_spacing (GTK_GRID (grid), 15);
+  for (i = 0; i < tab->ppd_options->len; i++)
+    ppd_option_add (g_ptr_array_index (tab->ppd_options, i),
+                    self->printer_name,
+                    tab,
+                    self->sensitive);
 
-  return grid;
+  g_ptr_array_set_size (tab->ppd_options, 0);
 }
 
 static void
 tab_add (PpOptionsDialog *self,
          const gchar     *tab_name,
-         GtkWidget       *grid)
+         OptionsTab      *tab)
 {
   GtkListStore *store;
   GtkTreeIter   iter;
@@ -435,14 +425,14 @@ tab_add (PpOptionsDialog *self,
   gboolean      unref_store = FALSE;
   gint          id;
 
-  if (!grid_is_empty (grid))
+  if (!options_tab_is_empty (tab))
     {
       scrolled_window = gtk_scrolled_window_new (NULL, NULL);
       gtk_widget_show (GTK_WIDGET (scrolled_window));
       gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
                                       GTK_POLICY_NEVER,
                                       GTK_POLICY_AUTOMATIC);
-      gtk_container_add (GTK_CONTAINER (scrolled_window), grid);
+      gtk_container_add (GTK_CONTAINER (scrolled_window), tab->grid);
 
       id = gtk_notebook_append_page (self->notebook,
                                      scrolled_window,
@@ -468,13 +458,13 @@ tab_add (PpOptionsDialog *self,
               gtk_tree_view_set_model (self->categories_treeview, GTK_TREE_MODEL (store));
               g_object_unref (store);
             }
+
+          g_ptr_array_add (self->tabs, tab);
+          return;
         }
     }
-  else
-    {
-      g_object_ref_sink (grid);
-      g_object_unref (grid);
-    }
+
+  options_tab_free (tab);
 }
 
 static void
@@ -493,6 +483,9 @@ category_selection_changed_cb (PpOptionsDialog *self)
 
   if (id >= 0)
     {
+      if (self->tabs != NULL && (guint) id < self->tabs->len)
+        tab_populate (self, g_ptr_array_index (self->tabs, id));
+
       gtk_notebook_set_current_page (self->notebook, id);
     }
 }
@@ -503,15 +496,15 @@ populate_options_real (PpOptionsDialog *self)
   GtkTreeModel *model;
   GtkTreeIter   iter;
   ppd_file_t   *ppd_file;
-  GtkWidget    *grid;
-  GtkWidget    *general_tab_grid = tab_grid_new ();
-  GtkWidget    *page_setup_tab_grid = tab_grid_new ();
-  GtkWidget    *installable_options_tab_grid = tab_grid_new ();
-  GtkWidget    *job_tab_grid = tab_grid_new ();
-  GtkWidget    *image_quality_tab_grid = tab_grid_new ();
-  GtkWidget    *color_tab_grid = tab_grid_new ();
-  GtkWidget    *finishing_tab_grid = tab_grid_new ();
-  GtkWidget    *advanced_tab_grid = tab_grid_new ();
+  OptionsTab   *tab;
+  OptionsTab   *general_tab = options_tab_new ();
+  OptionsTab   *page_setup_tab = options_tab_new ();
+  OptionsTab   *installable_options_tab = options_tab_new ();
+  OptionsTab   *job_tab = options_tab_new ();
+  OptionsTab   *image_quality_tab = options_tab_new ();
+  OptionsTab   *color_tab = options_tab_new ();
+  OptionsTab   *finishing_tab = options_tab_new ();
+  OptionsTab   *advanced_tab = options_tab_new ();
   gint          i, j;
 
   gtk_spinner_stop (self->spinner);
@@ -529,7 +522,7 @@ populate_options_real (PpOptionsDialog *self)
                       /* Translators: This option sets number of pages printed on one sheet */
                       _("Pages per side"),
                       self->printer_name,
-                      page_setup_tab_grid,
+                      page_setup_tab,
                       self->sensitive);
 
       /* Add sides option to Page Setup tab */
@@ -541,7 +534,7 @@ populate_options_real (PpOptionsDialog *self)
                       /* Translators: This option sets whether to print on both sides of paper */
                       _("Two-sided"),
                       self->printer_name,
-                      page_setup_tab_grid,
+                      page_setup_tab,
                       self->sensitive);
 
       /* Add orientation-requested option to Page Setup tab */
@@ -553,7 +546,7 @@ populate_options_real (PpOptionsDialog *self)
                       /* Translators: This option sets orientation of print (portrait, landscape...) */
                       _("Orientation"),
                       self->printer_name,
-                      page_setup_tab_grid,
+                      page_setup_tab,
                       self->sensitive);
     }
 
@@ -573,55 +566,60 @@ populate_options_real (PpOptionsDialog *self)
             {
               for (j = 0; j < ppd_file->groups[i].num_options; j++)
                 {
-                  grid = NULL;
+                  ppd_option_t *option = &ppd_file->groups[i].options[j];
+
+                  /* Options with only one choice get no widget */
+                  if (option->num_choices <= 1)
+                    continue;
+
+                  tab = NULL;
 
                   if (STRING_IN_TABLE (ppd_file->groups[i].name,
                                        allowed_color_groups))
-                    grid = color_tab_grid;
+                    tab = color_tab;
                   else if (STRING_IN_TABLE (ppd_file->groups[i].name,
                                             allowed_image_quality_groups))
-                    grid = image_quality_tab_grid;
+                    tab = image_quality_tab;
                   else if (STRING_IN_TABLE (ppd_file->groups[i].name,
                                             allowed_job_groups))
-                    grid = job_tab_grid;
+                    tab = job_tab;
                   else if (STRING_IN_TABLE (ppd_file->groups[i].name,
                                             allowed_finishing_groups))
-                    grid = finishing_tab_grid;
+                    tab = finishing_tab;
                   else if (STRING_IN_TABLE (ppd_file->groups[i].name,
                                             allowed_installable_options_groups))
-                    grid = installable_options_tab_grid;
+                    tab = installable_options_tab;
                   else if (STRING_IN_TABLE (ppd_file->groups[i].name,
                                             allowed_page_setup_groups))
-                    grid = page_setup_tab_grid;
+                    tab = page_setup_tab;
 
-                  if (!STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
+                  if (!STRING_IN_TABLE (option->keyword,
                                         disallowed_ppd_options))
                     {
-                      if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
-                                                    allowed_color_options))
-                        grid = color_tab_grid;
-                      else if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
-                                                         allowed_image_quality_options))
-                        grid = image_quality_tab_grid;
-                      else if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
-                                                         allowed_finishing_options))
-                        grid = finishing_tab_grid;
-                      else if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
-                                                         allowed_page_setup_options))
-                        grid = page_setup_tab_grid;
-
-                      if (!grid)
-                        grid = advanced_tab_grid;
-
-                      ppd_option_add (ppd_file->groups[i].options[j],
-                                      self->printer_name,
-                                      grid,
-                                      self->sensitive);
+                      if (!tab && STRING_IN_TABLE (option->keyword,
+                                                   allowed_color_options))
+                        tab = color_tab;
+                      else if (!tab && STRING_IN_TABLE (option->keyword,
+                                                        allowed_image_quality_options))
+                        tab = image_quality_tab;
+                      else if (!tab && STRING_IN_TABLE (option->keyword,
+                                                        allowed_finishing_options))
+                        tab = finishing_tab;
+                      else if (!tab && STRING_IN_TABLE (option->keyword,
+                                                        allowed_page_setup_options))
+                        tab = page_setup_tab;
+
+                      if (!tab)
+                        tab = advanced_tab;
+
+                      g_ptr_array_add (tab->ppd_options, option);
                     }
                 }
             }
 
-          ppdClose (ppd_file);
+          /* Keep the PPD open, the tabs refer to its options */
+          g_clear_pointer (&self->ppd_file, ppdClose);
+          self->ppd_file = ppd_file;
         }
     }
 
@@ -648,28 +646,28 @@ populate_options_real (PpOptionsDialog *self)
     }
 
   /* Translators: "General" tab contains general printer options */
-  tab_add (self, C_("Printer Option Group", "General"), general_tab_grid);
+  tab_add (self, C_("Printer Option Group", "General"), general_tab);
 
   /* Translators: "Page Setup" tab contains settings related to pages (page size, paper source, etc.) */
-  tab_add (self, C_("Printer Option Group", "Page Setup"), page_setup_tab_grid);
+  tab_add (self, C_("Printer Option Group", "Page Setup"), page_setup_tab);
 
   /* Translators: "Installable Options" tab contains settings of presence of installed options (amount of RAM, duplex unit, etc.) */
-  tab_add (self, C_("Printer Option Group", "Installable Options"), installable_options_tab_grid);
+  tab_add (self, C_("Printer Option Group", "Installable Options"), installable_options_tab);
 
   /* Translators: "Job" tab contains settings for jobs */
-  tab_add (self, C_("Printer Option Group", "Job"), job_tab_grid);
+  tab_add (self, C_("Printer Option Group", "Job"), job_tab);
 
   /* Translators: "Image Quality" tab contains settings for quality of output print (e.g. resolution) */
-  tab_add (self, C_("Printer Option Group", "Image Quality"), image_quality_tab_grid);
+  tab_add (self, C_("Printer Option Group", "Image Quality"), image_quality_tab);
 
   /* Translators: "Color" tab contains color settings (e.g. color printing) */
-  tab_add (self, C_("Printer Option Group", "Color"), color_tab_grid);
+  tab_add (self, C_("Printer Option Group", "Color"), color_tab);
 
   /* Translators: "Finishing" tab contains finishing settings (e.g. booklet printing) */
-  tab_add (self, C_("Printer Option Group", "Finishing"), finishing_tab_grid);
+  tab_add (self, C_("Printer Option Group", "Finishing"), finishing_tab);
 
   /* Translators: "Advanced" tab contains all others settings */
-  tab_add (self, C_("Printer Option Group", "Advanced"), advanced_tab_grid);
+  tab_add (self, C_("Printer Option Group", "Advanced"), advanced_tab);
 
   /* Select the first option group */
   if ((model = gtk_tree_view_get_model (self->categories_treeview)) != NULL &&
@@ -922,6 +920,9 @@ pp_options_dialog_dispose (GObject *object)
       self->ipp_attributes = NULL;
     }
 
+  g_clear_pointer (&self->tabs, g_ptr_array_unref);
+  g_clear_pointer (&self->ppd_file, ppdClose);
+
   G_OBJECT_CLASS (pp_options_dialog_parent_class)->dispose (object);
 }
 
@@ -950,4 +951,6 @@ void
 pp_options_dialog_init (PpOptionsDialog *self)
 {
   gtk_widget_init_template (GTK_WIDGET (self));
+
+  self->tabs = g_ptr_array_new_with_free_func ((GDestroyNotify) options_tab_free);
 }
@@ -22,6 +22,7 @@
 
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
@@ -38,7 +39,8 @@
 enum
 {
   PPD_NAMES_COLUMN = 0,
-  PPD_DISPLAY_NAMES_COLUMN
+  PPD_DISPLAY_NAMES_COLUMN,
+  PPD_SEARCH_KEYS_COLUMN
 };
 
 enum
@@ -56,6 +58,7 @@ struct _PpPPDSelectionDialog {
   GtkLabel    *progress_label;
   GtkTreeView *ppd_selection_manufacturers_treeview;
   GtkTreeView *ppd_selection_models_treeview;
+  GtkSearchEntry *ppd_search_entry;
 
   UserResponseCallback user_callback;
   gpointer             user_data;
@@ -65,20 +68,150 @@ struct _PpPPDSelectionDialog {
   gchar           *manufacturer;
 
   PPDList *list;
+
+  /* Models of each manufacturer, built when it is selected first */
+  GHashTable   *manufacturer_models;
+
+  /* All models of all manufacturers, filtered by the search entry */
+  GtkListStore *all_models;
+  GtkTreeModel *all_models_filter;
+  gchar        *search_key;
 };
 
 G_DEFINE_TYPE (PpPPDSelectionDialog, pp_ppd_selection_dialog, GTK_TYPE_DIALOG)
 
+static gchar *
+get_search_key (const gchar *text)
+{
+  g_autofree gchar *normalized = NULL;
+
+  normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+  if (normalized == NULL)
+    return NULL;
+
+  return g_utf8_casefold (normalized, -1);
+}
+
+static GtkListStore *
+get_manufacturer_models (PpPPDSelectionDialog *self,
+                         const gchar          *manufacturer_name)
+{
+  PPDManufacturerItem *manufacturer = NULL;
+  GtkListStore        *store;
+  GtkTreeIter          iter;
+  gsize                i;
+
+  store = g_hash_table_lookup (self->manufacturer_models, manufacturer_name);
+  if (store != NULL)
+    return store;
+
+  for (i = 0; i < self->list->num_of_manufacturers; i++)
+    {
+      if (g_strcmp0 (manufacturer_name,
+                     self->list->manufacturers[i]->manufacturer_name) == 0)
+        {
+          manufacturer = self->list->manufacturers[i];
+          break;
+        }
+    }
+
+  if (manufacturer == NULL)
+    return NULL;
+
+  store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_STRING);
+
+  for (i = 0; i < manufacturer->num_of_ppds; i++)
+    {
+      gtk_list_store_insert_with_values (store, &iter, -1,
+                                         PPD_NAMES_COLUMN, manufacturer->ppds[i]->ppd_name,
+                                         PPD_DISPLAY_NAMES_COLUMN, manufacturer->ppds[i]->ppd_display_name,
+                                         -1);
+    }
+
+  g_hash_table_insert (self->manufacturer_models, g_strdup (manufacturer_name), store);
+
+  return store;
+}
+
+static gboolean
+all_models_visible_func (GtkTreeModel *model,
+                         GtkTreeIter  *iter,
+                         gpointer      user_data)
+{
+  PpPPDSelectionDialog *self = user_data;
+  g_autofree gchar     *search_key = NULL;
+
+  if (self->search_key == NULL)
+    return TRUE;
+
+  gtk_tree_model_get (model, iter,
+                      PPD_SEARCH_KEYS_COLUMN, &search_key,
+                      -1);
+
+  return search_key != NULL && strstr (search_key, self->search_key) != NULL;
+}
+
+static void
+ensure_all_models (PpPPDSelectionDialog *self)
+{
+  GtkTreeIter iter;
+  gsize       i, j;
+
+  if (self->all_models != NULL)
+    return;
+
+  self->all_models = gtk_list_store_new (3, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+
+  for (i = 0; i < self->list->num_of_manufacturers; i++)
+    {
+      PPDManufacturerItem *manufacturer = self->list->manufacturers[i];
+
+      for (j = 0; j < manufacturer->num_of_ppds; j++)
+        {
+          g_autofree gchar *text = NULL;
+          g_autofree gchar *search_key = NULL;
+
+          text = g_strdup_printf ("%s %s",
+                                  manufacturer->manufacturer_display_name,
+                                  manufacturer->ppds[j]->ppd_display_name);
+          search_key = get_search_key (text);
+
+          gtk_list_store_insert_with_values (self->all_models, &iter, -1,
+                                             PPD_NAMES_COLUMN, manufacturer->ppds[j]->ppd_name,
+                                             PPD_DISPLAY_NAMES_COLUMN, manufacturer->ppds[j]->ppd_display_name,
+                                             PPD_SEARCH_KEYS_COLUMN, search_key,
+                                             -1);
+        }
+    }
+
+  self->all_models_filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (self->all_models), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (self->all_models_filter),
+                                          all_models_visible_func,
+                                          self,
+                                          NULL);
+}
+
+static void
+clear_models (PpPPDSelectionDialog *self)
+{
+  g_hash_table_remove_all (self->manufacturer_models);
+  g_clear_object (&self->all_models_filter);
+  g_clear_object (&self->all_models);
+}
+
 static void
 manufacturer_selection_changed_cb (PpPPDSelectionDialog *self)
 {
   GtkTreeView  *treeview;
-  g_autoptr(GtkListStore) store = NULL;
+  GtkListStore *store;
   GtkTreeModel *model;
   GtkTreeIter   iter;
   GtkTreeView  *models_treeview;
-  gchar        *manufacturer_name = NULL;
-  gint          i, index;
+  g_autofree gchar *manufacturer_name = NULL;
+
+  /* The search results replace the models of the selected manufacturer */
+  if (self->search_key != NULL)
+    return;
 
   treeview = self->ppd_selection_manufacturers_treeview;
   if (gtk_tree_selection_get_selected (gtk_tree_view_get_selection (treeview), &model, &iter))
@@ -90,37 +223,51 @@ manufacturer_selection_changed_cb (PpPPDSelectionDialog *self)
 
   if (manufacturer_name)
     {
-      index = -1;
-      for (i = 0; i < self->list->num_of_manufacturers; i++)
-        {
-          if (g_strcmp0 (manufacturer_name,
-                         self->list->manufacturers[i]->manufacturer_name) == 0)
-            {
-              index = i;
-              break;
-            }
-        }
-
-      if (index >= 0)
+      store = get_manufacturer_models (self, manufacturer_name);
+      if (store != NULL)
         {
           models_treeview = self->ppd_selection_models_treeview;
 
-          store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_STRING);
-
-          for (i = 0; i < self->list->manufacturers[index]->num_of_ppds; i++)
-            {
-              gtk_list_store_append (store, &iter);
-              gtk_list_store_set (store, &iter,
-                                  PPD_NAMES_COLUMN, self->list->manufacturers[index]->ppds[i]->ppd_name,
-                                  PPD_DISPLAY_NAMES_COLUMN, self->list->manufacturers[index]->ppds[i]->ppd_display_name,
-                                  -1);
-            }
-
           gtk_tree_view_set_model (models_treeview, GTK_TREE_MODEL (store));
           gtk_tree_view_columns_autosize (models_treeview);
         }
+    }
+}
+
+static void
+search_changed_cb (PpPPDSelectionDialog *self)
+{
+  GtkTreeView *models_treeview;
+  const gchar *text;
+
+  if (self->list == NULL)
+    return;
+
+  models_treeview = self->ppd_selection_models_treeview;
+  text = gtk_entry_get_text (GTK_ENTRY (self->ppd_search_entry));
+
+  g_clear_pointer (&self->search_key, g_free);
+  if (text != NULL && text[0] != '\0')
+    self->search_key = get_search_key (text);
+
+  gtk_widget_set_sensitive (GTK_WIDGET (self->ppd_selection_manufacturers_treeview),
+                            self->search_key == NULL);
 
-      g_free (manufacturer_name);
+  if (self->search_key != NULL)
+    {
+      ensure_all_models (self);
+
+      /* Refilter while detached so that the view does not
+       * process a row signal for every model of the catalog */
+      gtk_tree_view_set_model (models_treeview, NULL);
+      gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (self->all_models_filter));
+      gtk_tree_view_set_model (models_treeview, self->all_models_filter);
+      gtk_tree_view_columns_autosize (models_treeview);
+    }
+  else
+    {
+      gtk_tree_view_set_model (models_treeview, NULL);
+      manufacturer_selection_changed_cb (self);
     }
 }
 
@@ -178,11 +325,10 @@ fill_ppds_list (PpPPDSelectionDialog *self)
 
       for (i = 0; i < self->list->num_of_manufacturers; i++)
         {
-          gtk_list_store_append (store, &iter);
-          gtk_list_store_set (store, &iter,
-                              PPD_MANUFACTURERS_NAMES_COLUMN, self->list->manufacturers[i]->manufacturer_name,
-                              PPD_MANUFACTURERS_DISPLAY_NAMES_COLUMN, self->list->manufacturers[i]->manufacturer_display_name,
-                              -1);
+          gtk_list_store_insert_with_values (store, &iter, -1,
+                                             PPD_MANUFACTURERS_NAMES_COLUMN, self->list->manufacturers[i]->manufacturer_name,
+                                             PPD_MANUFACTURERS_DISPLAY_NAMES_COLUMN, self->list->manufacturers[i]->manufacturer_display_name,
+                                             -1);
 
           if (g_strcmp0 (self->manufacturer,
                          self->list->manufacturers[i]->manufacturer_display_name) == 0)
@@ -192,6 +338,7 @@ fill_ppds_list (PpPPDSelectionDialog *self)
         }
 
       gtk_tree_view_set_model (treeview, GTK_TREE_MODEL (store));
+      gtk_widget_set_sensitive (GTK_WIDGET (self->ppd_search_entry), TRUE);
 
       if (preselect_iter &&
           (selection = gtk_tree_view_get_selection (treeview)) != NULL)
@@ -334,6 +481,10 @@ pp_ppd_selection_dialog_dispose (GObject *object)
   g_clear_pointer (&self->ppd_name, g_free);
   g_clear_pointer (&self->ppd_display_name, g_free);
   g_clear_pointer (&self->manufacturer, g_free);
+  g_clear_pointer (&self->search_key, g_free);
+  g_clear_pointer (&self->manufacturer_models, g_hash_table_unref);
+  g_clear_object (&self->all_models_filter);
+  g_clear_object (&self->all_models);
 
   G_OBJECT_CLASS (pp_ppd_selection_dialog_parent_class)->dispose (object);
 }
@@ -350,6 +501,9 @@ pp_ppd_selection_dialog_class_init (PpPPDSelectionDialogClass *klass)
   gtk_widget_class_bind_template_child (widget_class, PpPPDSelectionDialog, progress_label);
   gtk_widget_class_bind_template_child (widget_class, PpPPDSelectionDialog, ppd_selection_manufacturers_treeview);
   gtk_widget_class_bind_template_child (widget_class, PpPPDSelectionDialog, ppd_selection_models_treeview);
+  gtk_widget_class_bind_template_child (widget_class, PpPPDSelectionDialog, ppd_search_entry);
+
+  gtk_widget_class_bind_template_callback (widget_class, search_changed_cb);
 
   object_class->dispose = pp_ppd_selection_dialog_dispose;
 }
@@ -358,6 +512,8 @@ void
 pp_ppd_selection_dialog_init (PpPPDSelectionDialog *self)
 {
   gtk_widget_init_template (GTK_WIDGET (self));
+
+  self->manufacturer_models = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
 }
 
 gchar *
@@ -377,5 +533,7 @@ pp_ppd_selection_dialog_set_ppd_list (PpPPDSelectionDialog *self,
                                       PPDList              *list)
 {
   self->list = list;
+  clear_models (self);
   fill_ppds_list (self);
+  search_changed_cb (self);
 }
@@ -495,6 +495,32 @@ remove_printer (GtkButton      *button,
   g_signal_emit_by_name (self, "printer-delete");
 }
 
+void
+pp_printer_entry_set_jobs_count (PpPrinterEntry *self,
+                                 guint           jobs_count)
+{
+  g_autofree gchar *button_label = NULL;
+
+  if (jobs_count == 0)
+    {
+      /* Translators: This is the label of the button that opens the Jobs Dialog. */
+      button_label = g_strdup (_("No Active Jobs"));
+    }
+  else
+    {
+      /* Translators: This is the label of the button that opens the Jobs Dialog. */
+      button_label = g_strdup_printf (ngettext ("%u Job", "%u Jobs", jobs_count), jobs_count);
+    }
+
+  gtk_button_set_label (GTK_BUTTON (self->show_jobs_dialog_button), button_label);
+  gtk_widget_set_sensitive (self->show_jobs_dialog_button, jobs_count > 0);
+
+  if (self->pp_jobs_dialog != NULL)
+    {
+      pp_jobs_dialog_update (self->pp_jobs_dialog);
+    }
+}
+
 static void
 get_jobs_cb (GObject      *source_object,
              GAsyncResult *result,
@@ -503,7 +529,6 @@ get_jobs_cb (GObject      *source_object,
   PpPrinterEntry      *self = user_data;
   g_autoptr(GError)    error = NULL;
   g_autoptr(GPtrArray) jobs = NULL;
-  g_autofree gchar    *button_label = NULL;
 
   jobs = pp_printer_get_jobs_finish (PP_PRINTER (source_object), result, &error);
 
@@ -517,24 +542,7 @@ get_jobs_cb (GObject      *source_object,
       return;
     }
 
-  if (jobs->len == 0)
-    {
-      /* Translators: This is the label of the button that opens the Jobs Dialog. */
-      button_label = g_strdup (_("No Active Jobs"));
-    }
-  else
-    {
-      /* Translators: This is the label of the button that opens the Jobs Dialog. */
-      button_label = g_strdup_printf (ngettext ("%u Job", "%u Jobs", jobs->len), jobs->len);
-    }
-
-  gtk_button_set_label (GTK_BUTTON (self->show_jobs_dialog_button), button_label);
-  gtk_widget_set_sensitive (self->show_jobs_dialog_button, jobs->len > 0);
-
-  if (self->pp_jobs_dialog != NULL)
-    {
-      pp_jobs_dialog_update (self->pp_jobs_dialog);
-    }
+  pp_printer_entry_set_jobs_count (self, jobs->len);
 
   g_clear_object (&self->get_jobs_cancellable);
 }
@@ -928,8 +936,6 @@ pp_printer_entry_update (PpPrinterEntry *self,
   gtk_widget_set_visible (GTK_WIDGET (self->printer_inklevel_label), !ink_supply_is_empty);
   gtk_widget_set_visible (GTK_WIDGET (self->supply_frame), !ink_supply_is_empty);
 
-  pp_printer_entry_update_jobs_count (self);
-
   gtk_widget_set_sensitive (GTK_WIDGET (self->printer_default_checkbutton), self->is_authorized);
   gtk_widget_set_sensitive (GTK_WIDGET (self->remove_printer_menuitem), self->is_authorized);
 }
@@ -34,6 +34,9 @@ const gchar    *pp_printer_entry_get_location (PpPrinterEntry *self);
 
 void            pp_printer_entry_update_jobs_count (PpPrinterEntry *self);
 
+void            pp_printer_entry_set_jobs_count (PpPrinterEntry *self,
+                                                 guint           jobs_count);
+
 GSList         *pp_printer_entry_get_size_group_widgets (PpPrinterEntry *self);
 
 void            pp_printer_entry_show_jobs_dialog (PpPrinterEntry *self);
@@ -3489,16 +3489,79 @@ guess_device_hostname (PpPrintDevice *device)
   return result;
 }
 
+DeviceNames *
+device_names_new (void)
+{
+  DeviceNames *device_names;
+
+  device_names = g_new0 (DeviceNames, 1);
+  device_names->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  device_names->suffix_hints = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  return device_names;
+}
+
+void
+device_names_free (DeviceNames *device_names)
+{
+  if (device_names)
+    {
+      g_hash_table_unref (device_names->names);
+      g_hash_table_unref (device_names->suffix_hints);
+      g_free (device_names);
+    }
+}
+
+void
+device_names_add (DeviceNames *device_names,
+                  const gchar *name)
+{
+  guint count;
+
+  if (name == NULL)
+    return;
+
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (device_names->names, name));
+  g_hash_table_insert (device_names->names, g_strdup (name), GUINT_TO_POINTER (count + 1));
+}
+
+void
+device_names_remove (DeviceNames *device_names,
+                     const gchar *name)
+{
+  guint count;
+
+  if (name == NULL)
+    return;
+
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (device_names->names, name));
+  if (count > 1)
+    {
+      g_hash_table_insert (device_names->names, g_strdup (name), GUINT_TO_POINTER (count - 1));
+    }
+  else if (count == 1)
+    {
+      g_hash_table_remove (device_names->names, name);
+
+      /* A suffix below a hint could be free now */
+      g_hash_table_remove_all (device_names->suffix_hints);
+    }
+}
+
+gboolean
+device_names_contains (DeviceNames *device_names,
+                       const gchar *name)
+{
+  return device_names != NULL &&
+         name != NULL &&
+         g_hash_table_contains (device_names->names, name);
+}
+
 gchar *
-canonicalize_device_name (GList         *device_names,
-                          GPtrArray     *local_cups_devices,
-                          cups_dest_t   *dests,
-                          gint           num_of_dests,
+canonicalize_device_name (DeviceNames   *device_names,
                           PpPrintDevice *device)
 {
-  PpPrintDevice             *item;
   gboolean                   already_present;
-  GList                     *iter;
   gsize                      len;
   g_autofree gchar          *name = NULL;
   gchar                     *occurrence;
@@ -3585,43 +3648,30 @@ canonicalize_device_name (GList         *device_names,
   if (name[0] == '-')
     shift_string_left (name);
 
-  name_index = 2;
-  already_present = FALSE;
+  if (!device_names_contains (device_names, name))
+    return g_steal_pointer (&name);
+
+  /* Suffixes below the hint were taken when the name was canonicalized last time */
+  name_index = GPOINTER_TO_INT (g_hash_table_lookup (device_names->suffix_hints, name));
+  if (name_index < 2)
+    name_index = 2;
+
   while (TRUE)
     {
       g_autofree gchar *new_name = NULL;
 
-      if (already_present)
-        {
-          new_name = g_strdup_printf ("%s-%d", name, name_index);
-          name_index++;
-        }
-      else
-        {
-          new_name = g_strdup (name);
-        }
-
-      already_present = FALSE;
-      for (j = 0; j < num_of_dests; j++)
-        if (g_strcmp0 (dests[j].name, new_name) == 0)
-          already_present = TRUE;
+      new_name = g_strdup_printf ("%s-%d", name, name_index);
+      already_present = device_names_contains (device_names, new_name);
 
-      for (iter = device_names; iter; iter = iter->next)
-        {
-          gchar *device_original_name = iter->data;
-          if (g_strcmp0 (device_original_name, new_name) == 0)
-            already_present = TRUE;
-        }
-
-      for (guint i = 0; i < local_cups_devices->len; i++)
+      if (!already_present)
         {
-          item = g_ptr_array_index (local_cups_devices, i);
-          if (g_strcmp0 (pp_print_device_get_device_original_name (item), new_name) == 0)
-            already_present = TRUE;
+          g_hash_table_insert (device_names->suffix_hints,
+                               g_strdup (name),
+                               GINT_TO_POINTER (name_index));
+          return g_steal_pointer (&new_name);
         }
 
-      if (!already_present)
-        return g_steal_pointer (&new_name);
+      name_index++;
     }
 }
 
@@ -250,10 +250,28 @@ void        get_cups_devices_async (GCancellable *cancellable,
 
 gchar      *guess_device_hostname (PpPrintDevice *device);
 
-gchar      *canonicalize_device_name (GList         *device_names,
-                                      GPtrArray     *local_cups_devices,
-                                      cups_dest_t   *dests,
-                                      gint           num_of_dests,
+typedef struct
+{
+  /* Name -> number of devices and printers holding it */
+  GHashTable *names;
+  /* Name -> first suffix which could still be free for it */
+  GHashTable *suffix_hints;
+} DeviceNames;
+
+DeviceNames *device_names_new (void);
+
+void        device_names_free (DeviceNames *device_names);
+
+void        device_names_add (DeviceNames *device_names,
+                              const gchar *name);
+
+void        device_names_remove (DeviceNames *device_names,
+                                 const gchar *name);
+
+gboolean    device_names_contains (DeviceNames *device_names,
+                                   const gchar *name);
+
+gchar      *canonicalize_device_name (DeviceNames   *device_names,
                                       PpPrintDevice *device);
 
 void        shift_string_left (gchar *str);
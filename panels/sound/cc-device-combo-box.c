@@ -24,6 +24,7 @@ struct _CcDeviceComboBox
   GtkComboBox      parent_instance;
 
   GtkListStore    *device_model;
+  GHashTable      *iters_by_id;
 
   GvcMixerControl *mixer_control;
   guint            added_handler_id;
@@ -34,6 +35,22 @@ struct _CcDeviceComboBox
 
 G_DEFINE_TYPE (CcDeviceComboBox, cc_device_combo_box, GTK_TYPE_COMBO_BOX)
 
+/* GtkListStore iters stay valid as long as their row exists */
+static gboolean
+get_iter (CcDeviceComboBox *self,
+          guint             id,
+          GtkTreeIter      *iter)
+{
+  GtkTreeIter *stored_iter;
+
+  stored_iter = g_hash_table_lookup (self->iters_by_id, GUINT_TO_POINTER (id));
+  if (stored_iter == NULL)
+    return FALSE;
+
+  *iter = *stored_iter;
+  return TRUE;
+}
+
 static void
 device_added_cb (CcDeviceComboBox *self,
                  guint             id)
@@ -66,7 +83,13 @@ device_added_cb (CcDeviceComboBox *self,
   if (gvc_mixer_ui_device_get_icon_name (device) != NULL)
     icon_name = g_strdup_printf ("%s-symbolic", gvc_mixer_ui_device_get_icon_name (device));
 
-  gtk_list_store_append (self->device_model, &iter);
+  /* Update the existing row if the device is announced again */
+  if (!get_iter (self, id, &iter))
+    {
+      gtk_list_store_append (self->device_model, &iter);
+      g_hash_table_insert (self->iters_by_id, GUINT_TO_POINTER (id), gtk_tree_iter_copy (&iter));
+    }
+
   gtk_list_store_set (self->device_model, &iter,
                       0, label,
                       1, icon_name,
@@ -74,34 +97,17 @@ device_added_cb (CcDeviceComboBox *self,
                       -1);
 }
 
-static gboolean
-get_iter (CcDeviceComboBox *self,
-          guint             id,
-          GtkTreeIter      *iter)
-{
-  if (!gtk_tree_model_get_iter_first (GTK_TREE_MODEL (self->device_model), iter))
-    return FALSE;
-
-  do
-    {
-      guint i;
-
-      gtk_tree_model_get (GTK_TREE_MODEL (self->device_model), iter, 2, &i, -1);
-      if (i == id)
-        return TRUE;
-    } while (gtk_tree_model_iter_next (GTK_TREE_MODEL (self->device_model), iter));
-
-  return FALSE;
-}
-
 static void
 device_removed_cb (CcDeviceComboBox *self,
                    guint             id)
 {
   GtkTreeIter iter;
 
-  if (get_iter (self, id, &iter))
-    gtk_list_store_remove (self->device_model, &iter);
+  if (!get_iter (self, id, &iter))
+    return;
+
+  g_hash_table_remove (self->iters_by_id, GUINT_TO_POINTER (id));
+  gtk_list_store_remove (self->device_model, &iter);
 }
 
 static void
@@ -124,6 +130,16 @@ cc_device_combo_box_dispose (GObject *object)
   G_OBJECT_CLASS (cc_device_combo_box_parent_class)->dispose (object);
 }
 
+static void
+cc_device_combo_box_finalize (GObject *object)
+{
+  CcDeviceComboBox *self = CC_DEVICE_COMBO_BOX (object);
+
+  g_clear_pointer (&self->iters_by_id, g_hash_table_unref);
+
+  G_OBJECT_CLASS (cc_device_combo_box_parent_class)->finalize (object);
+}
+
 void
 cc_device_combo_box_class_init (CcDeviceComboBoxClass *klass)
 {
@@ -131,6 +147,7 @@ cc_device_combo_box_class_init (CcDeviceComboBoxClass *klass)
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
   object_class->dispose = cc_device_combo_box_dispose;
+  object_class->finalize = cc_device_combo_box_finalize;
 
   gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/control-center/sound/cc-device-combo-box.ui");
 
@@ -142,6 +159,10 @@ cc_device_combo_box_init (CcDeviceComboBox *self)
 {
   g_resources_register (cc_sound_get_resource ());
 
+  /* Device ID → GtkTreeIter in device_model */
+  self->iters_by_id = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                             NULL, (GDestroyNotify) gtk_tree_iter_free);
+
   gtk_widget_init_template (GTK_WIDGET (self));
 }
 
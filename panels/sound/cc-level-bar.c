@@ -16,19 +16,29 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
+
 #include "cc-level-bar.h"
+#include "cc-peak-monitor.h"
 #include "cc-sound-enums.h"
-#include "gvc-mixer-stream-private.h"
 
 struct _CcLevelBar
 {
   GtkWidget             parent_instance;
 
   CcStreamType          type;
-  pa_stream            *level_stream;
+  CcPeakMonitor        *monitor;
+  gboolean              monitor_held;
   gdouble               last_input_peak;
+  guint                 hold_frames;
 
   gdouble               value;
+
+  GdkRGBA               inactive_color;
+  GdkRGBA               active_color;
+
+  /* All LEDs switched off, rendered on demand */
+  cairo_surface_t      *off_surface;
 };
 
 G_DEFINE_TYPE (CcLevelBar, cc_level_bar, GTK_TYPE_WIDGET)
@@ -37,20 +47,40 @@ G_DEFINE_TYPE (CcLevelBar, cc_level_bar, GTK_TYPE_WIDGET)
 #define LED_HEIGHT  3
 #define LED_SPACING 4
 
-#define DECAY_STEP .15
+/* The displayed level falls by at most this much per second */
+#define DECAY_PER_SECOND 3.75
+
+/* A new maximum is held this long before it starts to fall */
+#define PEAK_HOLD_SECONDS 0.25
 
 static void
 set_peak (CcLevelBar *self,
           gdouble     value)
 {
+  guint rate;
+  gdouble decay_step;
+
   if (value < 0)
      value = 0;
   if (value > 1)
      value = 1;
 
-  if (self->last_input_peak >= DECAY_STEP &&
-      value < self->last_input_peak - DECAY_STEP)
-    value = self->last_input_peak - DECAY_STEP;
+  rate = cc_peak_monitor_get_rate (self->monitor);
+  decay_step = DECAY_PER_SECOND / rate;
+
+  if (value >= self->last_input_peak)
+    {
+      self->hold_frames = (guint) ceil (PEAK_HOLD_SECONDS * rate);
+    }
+  else if (self->hold_frames > 0)
+    {
+      self->hold_frames--;
+      value = self->last_input_peak;
+    }
+  else if (value < self->last_input_peak - decay_step)
+    {
+      value = self->last_input_peak - decay_step;
+    }
   self->last_input_peak = value;
 
   self->value = value;
@@ -58,48 +88,50 @@ set_peak (CcLevelBar *self,
 }
 
 static void
-read_cb (pa_stream *stream,
-         size_t     length,
-         void      *userdata)
+peak_cb (CcLevelBar *self,
+         gdouble     value)
 {
-  CcLevelBar *self = userdata;
-  const void *data;
-  gdouble value;
-
-  if (pa_stream_peek (stream, &data, &length) < 0)
-    {
-      g_warning ("Failed to read data from stream");
-      return;
-    }
-
-  if (!data)
-    {
-      pa_stream_drop (stream);
-      return;
-    }
+  set_peak (self, value);
+}
 
-  assert (length > 0);
-  assert (length % sizeof (float) == 0);
+static void
+suspended_cb (CcLevelBar *self)
+{
+  self->last_input_peak = 0.0;
+  self->hold_frames = 0;
+  self->value = 0.0;
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
 
-  value = ((const float *) data)[length / sizeof (float) -1];
+/* Only keep the shared monitor stream running while we are visible */
+static void
+update_monitoring (CcLevelBar *self)
+{
+  gboolean hold;
 
-  pa_stream_drop (stream);
+  hold = self->monitor != NULL && gtk_widget_get_mapped (GTK_WIDGET (self));
+  if (hold == self->monitor_held)
+    return;
 
-  set_peak (self, value);
+  self->monitor_held = hold;
+  if (hold)
+    cc_peak_monitor_hold (self->monitor);
+  else
+    cc_peak_monitor_release (self->monitor);
 }
 
 static void
-suspended_cb (pa_stream *stream,
-              void      *userdata)
+clear_monitor (CcLevelBar *self)
 {
-  CcLevelBar *self = userdata;
+  if (self->monitor == NULL)
+    return;
 
-  if (pa_stream_is_suspended (stream))
-    {
-      g_debug ("Stream suspended");
-      self->value = 0.0;
-      gtk_widget_queue_draw (GTK_WIDGET (self));
-    }
+  if (self->monitor_held)
+    cc_peak_monitor_release (self->monitor);
+  self->monitor_held = FALSE;
+
+  g_signal_handlers_disconnect_by_data (self->monitor, self);
+  g_clear_object (&self->monitor);
 }
 
 static void
@@ -119,49 +151,106 @@ set_source_blend (cairo_t *cr, GdkRGBA *a, GdkRGBA *b, gdouble f)
                         (1.0 - f) * a->blue  + f * b->blue);
 }
 
-static gboolean
-cc_level_bar_draw (GtkWidget *widget,
-                   cairo_t   *cr)
+static void
+get_led_layout (CcLevelBar *self,
+                int        *n_leds,
+                double     *spacing)
 {
-  CcLevelBar *self = CC_LEVEL_BAR (widget);
-  GtkAllocation allocation;
-  GdkRGBA inactive_color, active_color;
-  int i, n_leds;
-  double level;
-  double spacing, x_offset = 0.0;
-
-  gtk_widget_get_allocation (widget, &allocation);
+  int width = gtk_widget_get_allocated_width (GTK_WIDGET (self));
 
-  n_leds = allocation.width / (LED_WIDTH + LED_SPACING);
-  spacing = (double) (allocation.width - (n_leds * LED_WIDTH)) / (n_leds - 1);
-  level = self->value * n_leds;
+  *n_leds = width / (LED_WIDTH + LED_SPACING);
+  if (*n_leds > 1)
+    *spacing = (double) (width - (*n_leds * LED_WIDTH)) / (*n_leds - 1);
+  else
+    *spacing = 0.0;
+}
 
-  gdk_rgba_parse (&inactive_color, "#C0C0C0");
+static void
+update_colors (CcLevelBar *self)
+{
+  gdk_rgba_parse (&self->inactive_color, "#C0C0C0");
   switch (self->type)
   {
   default:
   case CC_STREAM_TYPE_OUTPUT:
-    gdk_rgba_parse (&active_color, "#4a90d9");
+    gdk_rgba_parse (&self->active_color, "#4a90d9");
     break;
   case CC_STREAM_TYPE_INPUT:
-    gdk_rgba_parse (&active_color, "#ff0000");
+    gdk_rgba_parse (&self->active_color, "#ff0000");
     break;
   }
+}
 
+static cairo_surface_t *
+get_off_surface (CcLevelBar *self)
+{
+  GtkWidget *widget = GTK_WIDGET (self);
+  cairo_t *cr;
+  int i, n_leds, width, height;
+  double spacing, x_offset = 0.0;
+
+  if (self->off_surface)
+    return self->off_surface;
+
+  width = gtk_widget_get_allocated_width (widget);
+  height = gtk_widget_get_allocated_height (widget);
+  get_led_layout (self, &n_leds, &spacing);
+
+  self->off_surface = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
+                                                         CAIRO_CONTENT_COLOR_ALPHA,
+                                                         MAX (width, 1), MAX (height, 1));
+  cr = cairo_create (self->off_surface);
+  gdk_cairo_set_source_rgba (cr, &self->inactive_color);
   for (i = 0; i < n_leds; i++)
+  {
+    cairo_rectangle (cr,
+                     x_offset, 0,
+                     LED_WIDTH, height);
+    x_offset += LED_WIDTH + spacing;
+  }
+  cairo_fill (cr);
+  cairo_destroy (cr);
+
+  return self->off_surface;
+}
+
+static void
+invalidate_off_surface (CcLevelBar *self)
+{
+  g_clear_pointer (&self->off_surface, cairo_surface_destroy);
+}
+
+static gboolean
+cc_level_bar_draw (GtkWidget *widget,
+                   cairo_t   *cr)
+{
+  CcLevelBar *self = CC_LEVEL_BAR (widget);
+  int i, n_leds, n_lit;
+  double level;
+  double spacing, x_offset = 0.0;
+  int height;
+
+  height = gtk_widget_get_allocated_height (widget);
+  get_led_layout (self, &n_leds, &spacing);
+  level = self->value * n_leds;
+
+  cairo_set_source_surface (cr, get_off_surface (self), 0, 0);
+  cairo_paint (cr);
+
+  /* Only the LEDs that are (partly) lit need to be drawn on top */
+  n_lit = MIN (n_leds, (int) ceil (level));
+  for (i = 0; i < n_lit; i++)
   {
     double led_level;
 
     led_level = level - i;
-    if (led_level < 0.0)
-      led_level = 0.0;
-    else if (led_level > 1.0)
+    if (led_level > 1.0)
       led_level = 1.0;
 
     cairo_rectangle (cr,
                      x_offset, 0,
-                     LED_WIDTH, allocation.height);
-    set_source_blend (cr, &inactive_color, &active_color, led_level);
+                     LED_WIDTH, height);
+    set_source_blend (cr, &self->inactive_color, &self->active_color, led_level);
     cairo_fill (cr);
     x_offset += LED_WIDTH + spacing;
   }
@@ -170,17 +259,50 @@ cc_level_bar_draw (GtkWidget *widget,
 }
 
 static void
-close_stream (pa_stream *stream)
+cc_level_bar_size_allocate (GtkWidget     *widget,
+                            GtkAllocation *allocation)
 {
-  if (stream == NULL)
-    return;
+  CcLevelBar *self = CC_LEVEL_BAR (widget);
+  GtkAllocation old_allocation;
+
+  gtk_widget_get_allocation (widget, &old_allocation);
+  if (old_allocation.width != allocation->width ||
+      old_allocation.height != allocation->height)
+    invalidate_off_surface (self);
+
+  GTK_WIDGET_CLASS (cc_level_bar_parent_class)->size_allocate (widget, allocation);
+}
 
-  /* Stop receiving data */
-  pa_stream_set_read_callback (stream, NULL, NULL);
-  pa_stream_set_suspended_callback (stream, NULL, NULL);
+static void
+cc_level_bar_style_updated (GtkWidget *widget)
+{
+  invalidate_off_surface (CC_LEVEL_BAR (widget));
 
-  /* Disconnect from the stream */
-  pa_stream_disconnect (stream);
+  GTK_WIDGET_CLASS (cc_level_bar_parent_class)->style_updated (widget);
+}
+
+static void
+cc_level_bar_unrealize (GtkWidget *widget)
+{
+  invalidate_off_surface (CC_LEVEL_BAR (widget));
+
+  GTK_WIDGET_CLASS (cc_level_bar_parent_class)->unrealize (widget);
+}
+
+static void
+cc_level_bar_map (GtkWidget *widget)
+{
+  GTK_WIDGET_CLASS (cc_level_bar_parent_class)->map (widget);
+
+  update_monitoring (CC_LEVEL_BAR (widget));
+}
+
+static void
+cc_level_bar_unmap (GtkWidget *widget)
+{
+  GTK_WIDGET_CLASS (cc_level_bar_parent_class)->unmap (widget);
+
+  update_monitoring (CC_LEVEL_BAR (widget));
 }
 
 static void
@@ -188,8 +310,8 @@ cc_level_bar_dispose (GObject *object)
 {
   CcLevelBar *self = CC_LEVEL_BAR (object);
 
-  close_stream (self->level_stream);
-  g_clear_pointer (&self->level_stream, pa_stream_unref);
+  clear_monitor (self);
+  invalidate_off_surface (self);
 
   G_OBJECT_CLASS (cc_level_bar_parent_class)->dispose (object);
 }
@@ -204,12 +326,19 @@ cc_level_bar_class_init (CcLevelBarClass *klass)
 
   widget_class->get_preferred_height = cc_level_bar_get_preferred_height;
   widget_class->draw = cc_level_bar_draw;
+  widget_class->size_allocate = cc_level_bar_size_allocate;
+  widget_class->style_updated = cc_level_bar_style_updated;
+  widget_class->unrealize = cc_level_bar_unrealize;
+  widget_class->map = cc_level_bar_map;
+  widget_class->unmap = cc_level_bar_unmap;
 }
 
 void
 cc_level_bar_init (CcLevelBar *self)
 {
   gtk_widget_set_has_window (GTK_WIDGET (self), FALSE);
+
+  update_colors (self);
 }
 
 void
@@ -217,62 +346,24 @@ cc_level_bar_set_stream (CcLevelBar     *self,
                          GvcMixerStream *stream,
                          CcStreamType    type)
 {
-  pa_context *context;
-  pa_sample_spec sample_spec;
-  pa_proplist *proplist;
-  pa_buffer_attr  attr;
-  g_autofree gchar *device = NULL;
-
   g_return_if_fail (CC_IS_LEVEL_BAR (self));
 
-  close_stream (self->level_stream);
-  g_clear_pointer (&self->level_stream, pa_stream_unref);
+  clear_monitor (self);
+  self->last_input_peak = 0.0;
+  self->hold_frames = 0;
+  self->value = 0.0;
 
   self->type = type;
+  update_colors (self);
 
-  if (stream == NULL)
-   {
-     gtk_widget_queue_draw (GTK_WIDGET (self));
-     return;
-   }
-
-  context = gvc_mixer_stream_get_pa_context (stream);
-
-  if (pa_context_get_server_protocol_version (context) < 13)
-    {
-      g_warning ("Unsupported version of PulseAudio");
-      return;
-    }
-
-  sample_spec.channels = 1;
-  sample_spec.format = PA_SAMPLE_FLOAT32;
-  sample_spec.rate = 25;
-
-  proplist = pa_proplist_new ();
-  pa_proplist_sets (proplist, PA_PROP_APPLICATION_ID, "org.gnome.VolumeControl");
-  self->level_stream = pa_stream_new_with_proplist (context, "Peak detect", &sample_spec, NULL, proplist);
-  pa_proplist_free (proplist);
-  if (self->level_stream == NULL)
-    {
-      g_warning ("Failed to create monitoring stream");
-      return;
-    }
-
-  pa_stream_set_read_callback (self->level_stream, read_cb, self);
-  pa_stream_set_suspended_callback (self->level_stream, suspended_cb, self);
-
-  memset (&attr, 0, sizeof (attr));
-  attr.fragsize = sizeof (float);
-  attr.maxlength = (uint32_t) -1;
-  device = g_strdup_printf ("%u", gvc_mixer_stream_get_index (stream));
-  if (pa_stream_connect_record (self->level_stream,
-                                device,
-                                &attr,
-                                (pa_stream_flags_t) (PA_STREAM_DONT_MOVE |
-                                                     PA_STREAM_PEAK_DETECT |
-                                                     PA_STREAM_ADJUST_LATENCY)) < 0)
+  if (stream != NULL)
     {
-      g_warning ("Failed to connect monitoring stream");
+      self->monitor = cc_peak_monitor_get (stream);
+      g_signal_connect_object (self->monitor, "peak",
+                               G_CALLBACK (peak_cb), self, G_CONNECT_SWAPPED);
+      g_signal_connect_object (self->monitor, "suspended",
+                               G_CALLBACK (suspended_cb), self, G_CONNECT_SWAPPED);
+      update_monitoring (self);
     }
 
   gtk_widget_queue_draw (GTK_WIDGET (self));
@@ -0,0 +1,354 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <pulse/pulseaudio.h>
+
+#include "cc-peak-monitor.h"
+#include "gvc-mixer-stream-private.h"
+
+/*
+ * A peak-detect record stream that is shared between all the widgets
+ * showing the level of the same device. The stream is only connected
+ * while at least one of them holds the monitor.
+ */
+struct _CcPeakMonitor
+{
+  GObject     parent_instance;
+
+  gchar      *key;
+  pa_context *context;
+  guint       index;
+  pa_stream  *stream;
+  guint       hold_count;
+  guint       rate;
+};
+
+G_DEFINE_TYPE (CcPeakMonitor, cc_peak_monitor, G_TYPE_OBJECT)
+
+enum
+{
+  PEAK,
+  SUSPENDED,
+  N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = { 0 };
+
+enum
+{
+  PROP_0,
+  PROP_RATE
+};
+
+/* Maps "context:index" to the monitor, without holding a reference */
+static GHashTable *monitors = NULL;
+
+static gfloat
+get_peak (const gfloat *samples,
+          gsize         n_samples)
+{
+  gfloat peak = 0.0f;
+  gsize i;
+
+  /* Simple enough for the compiler to vectorize */
+  for (i = 0; i < n_samples; i++)
+    peak = MAX (peak, fabsf (samples[i]));
+
+  return peak;
+}
+
+static void
+read_cb (pa_stream *stream,
+         size_t     length,
+         void      *userdata)
+{
+  CcPeakMonitor *self = userdata;
+  const void *data;
+  gfloat value = 0.0f;
+  gboolean have_value = FALSE;
+
+  /* Reduce everything that arrived since the last callback, so that no
+   * peak gets lost. */
+  while (pa_stream_readable_size (stream) > 0)
+    {
+      if (pa_stream_peek (stream, &data, &length) < 0)
+        {
+          g_warning ("Failed to read data from stream");
+          return;
+        }
+
+      if (length == 0)
+        break;
+
+      if (data)
+        {
+          assert (length % sizeof (float) == 0);
+
+          value = MAX (value, get_peak (data, length / sizeof (float)));
+          have_value = TRUE;
+        }
+
+      pa_stream_drop (stream);
+    }
+
+  if (have_value)
+    g_signal_emit (self, signals[PEAK], 0, (gdouble) value);
+}
+
+static void
+suspended_cb (pa_stream *stream,
+              void      *userdata)
+{
+  CcPeakMonitor *self = userdata;
+
+  if (pa_stream_is_suspended (stream))
+    {
+      g_debug ("Stream suspended");
+      g_signal_emit (self, signals[SUSPENDED], 0);
+    }
+}
+
+static void
+open_stream (CcPeakMonitor *self)
+{
+  pa_sample_spec sample_spec;
+  pa_proplist *proplist;
+  pa_buffer_attr  attr;
+  g_autofree gchar *device = NULL;
+
+  if (pa_context_get_server_protocol_version (self->context) < 13)
+    {
+      g_warning ("Unsupported version of PulseAudio");
+      return;
+    }
+
+  sample_spec.channels = 1;
+  sample_spec.format = PA_SAMPLE_FLOAT32;
+  sample_spec.rate = self->rate;
+
+  proplist = pa_proplist_new ();
+  pa_proplist_sets (proplist, PA_PROP_APPLICATION_ID, "org.gnome.VolumeControl");
+  self->stream = pa_stream_new_with_proplist (self->context, "Peak detect", &sample_spec, NULL, proplist);
+  pa_proplist_free (proplist);
+  if (self->stream == NULL)
+    {
+      g_warning ("Failed to create monitoring stream");
+      return;
+    }
+
+  pa_stream_set_read_callback (self->stream, read_cb, self);
+  pa_stream_set_suspended_callback (self->stream, suspended_cb, self);
+
+  memset (&attr, 0, sizeof (attr));
+  attr.fragsize = sizeof (float);
+  attr.maxlength = (uint32_t) -1;
+  device = g_strdup_printf ("%u", self->index);
+  if (pa_stream_connect_record (self->stream,
+                                device,
+                                &attr,
+                                (pa_stream_flags_t) (PA_STREAM_DONT_MOVE |
+                                                     PA_STREAM_PEAK_DETECT |
+                                                     PA_STREAM_ADJUST_LATENCY)) < 0)
+    {
+      g_warning ("Failed to connect monitoring stream");
+    }
+}
+
+static void
+close_stream (CcPeakMonitor *self)
+{
+  if (self->stream == NULL)
+    return;
+
+  /* Stop receiving data */
+  pa_stream_set_read_callback (self->stream, NULL, NULL);
+  pa_stream_set_suspended_callback (self->stream, NULL, NULL);
+
+  /* Disconnect from the stream */
+  pa_stream_disconnect (self->stream);
+  g_clear_pointer (&self->stream, pa_stream_unref);
+}
+
+static void
+cc_peak_monitor_finalize (GObject *object)
+{
+  CcPeakMonitor *self = CC_PEAK_MONITOR (object);
+
+  close_stream (self);
+
+  if (monitors != NULL && g_hash_table_lookup (monitors, self->key) == self)
+    g_hash_table_remove (monitors, self->key);
+
+  g_clear_pointer (&self->context, pa_context_unref);
+  g_clear_pointer (&self->key, g_free);
+
+  G_OBJECT_CLASS (cc_peak_monitor_parent_class)->finalize (object);
+}
+
+static void
+cc_peak_monitor_set_property (GObject      *object,
+                              guint         property_id,
+                              const GValue *value,
+                              GParamSpec   *pspec)
+{
+  CcPeakMonitor *self = CC_PEAK_MONITOR (object);
+
+  switch (property_id) {
+  case PROP_RATE:
+    cc_peak_monitor_set_rate (self, g_value_get_uint (value));
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+cc_peak_monitor_get_property (GObject    *object,
+                              guint       property_id,
+                              GValue     *value,
+                              GParamSpec *pspec)
+{
+  CcPeakMonitor *self = CC_PEAK_MONITOR (object);
+
+  switch (property_id) {
+  case PROP_RATE:
+    g_value_set_uint (value, self->rate);
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+void
+cc_peak_monitor_class_init (CcPeakMonitorClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = cc_peak_monitor_finalize;
+  object_class->set_property = cc_peak_monitor_set_property;
+  object_class->get_property = cc_peak_monitor_get_property;
+
+  g_object_class_install_property (object_class, PROP_RATE,
+                                   g_param_spec_uint ("rate",
+                                                      NULL,
+                                                      NULL,
+                                                      1, 200,
+                                                      CC_PEAK_MONITOR_DEFAULT_RATE,
+                                                      G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
+  signals[PEAK] = g_signal_new ("peak",
+                                G_TYPE_FROM_CLASS (object_class),
+                                G_SIGNAL_RUN_LAST,
+                                0, NULL, NULL, NULL,
+                                G_TYPE_NONE,
+                                1, G_TYPE_DOUBLE);
+
+  signals[SUSPENDED] = g_signal_new ("suspended",
+                                     G_TYPE_FROM_CLASS (object_class),
+                                     G_SIGNAL_RUN_LAST,
+                                     0, NULL, NULL, NULL,
+                                     G_TYPE_NONE,
+                                     0);
+}
+
+void
+cc_peak_monitor_init (CcPeakMonitor *self)
+{
+  self->rate = CC_PEAK_MONITOR_DEFAULT_RATE;
+}
+
+/* Returns a new reference to the monitor shared by all users of @stream */
+CcPeakMonitor *
+cc_peak_monitor_get (GvcMixerStream *stream)
+{
+  CcPeakMonitor *self;
+  pa_context *context;
+  g_autofree gchar *key = NULL;
+
+  g_return_val_if_fail (GVC_IS_MIXER_STREAM (stream), NULL);
+
+  context = gvc_mixer_stream_get_pa_context (stream);
+  key = g_strdup_printf ("%p:%u", context, gvc_mixer_stream_get_index (stream));
+
+  if (monitors == NULL)
+    monitors = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, NULL);
+
+  self = g_hash_table_lookup (monitors, key);
+  if (self != NULL)
+    return g_object_ref (self);
+
+  self = g_object_new (CC_TYPE_PEAK_MONITOR, NULL);
+  self->key = g_steal_pointer (&key);
+  self->context = pa_context_ref (context);
+  self->index = gvc_mixer_stream_get_index (stream);
+  g_hash_table_insert (monitors, self->key, self);
+
+  return self;
+}
+
+/* Starts monitoring if this is the first holder */
+void
+cc_peak_monitor_hold (CcPeakMonitor *self)
+{
+  g_return_if_fail (CC_IS_PEAK_MONITOR (self));
+
+  if (self->hold_count++ == 0)
+    open_stream (self);
+}
+
+/* Stops monitoring once the last holder released the monitor */
+void
+cc_peak_monitor_release (CcPeakMonitor *self)
+{
+  g_return_if_fail (CC_IS_PEAK_MONITOR (self));
+  g_return_if_fail (self->hold_count > 0);
+
+  if (--self->hold_count == 0)
+    close_stream (self);
+}
+
+/* Number of peak values per second, shared by all holders */
+guint
+cc_peak_monitor_get_rate (CcPeakMonitor *self)
+{
+  g_return_val_if_fail (CC_IS_PEAK_MONITOR (self), CC_PEAK_MONITOR_DEFAULT_RATE);
+
+  return self->rate;
+}
+
+void
+cc_peak_monitor_set_rate (CcPeakMonitor *self,
+                          guint          rate)
+{
+  g_return_if_fail (CC_IS_PEAK_MONITOR (self));
+  g_return_if_fail (rate > 0);
+
+  if (self->rate == rate)
+    return;
+
+  self->rate = rate;
+
+  /* The rate is part of the sample spec, so reconnect a running stream */
+  if (self->stream != NULL)
+    {
+      close_stream (self);
+      open_stream (self);
+    }
+
+  g_object_notify (G_OBJECT (self), "rate");
+}
@@ -0,0 +1,41 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <gvc-mixer-stream.h>
+
+G_BEGIN_DECLS
+
+/* Default number of peak values PulseAudio sends per second */
+#define CC_PEAK_MONITOR_DEFAULT_RATE 30
+
+#define CC_TYPE_PEAK_MONITOR (cc_peak_monitor_get_type ())
+G_DECLARE_FINAL_TYPE (CcPeakMonitor, cc_peak_monitor, CC, PEAK_MONITOR, GObject)
+
+CcPeakMonitor *cc_peak_monitor_get     (GvcMixerStream *stream);
+
+void           cc_peak_monitor_hold    (CcPeakMonitor  *monitor);
+
+void           cc_peak_monitor_release (CcPeakMonitor  *monitor);
+
+guint          cc_peak_monitor_get_rate (CcPeakMonitor *monitor);
+
+void           cc_peak_monitor_set_rate (CcPeakMonitor *monitor,
+                                         guint          rate);
+
+G_END_DECLS
@@ -33,6 +33,7 @@ struct _CcStreamListBox
   CcStreamType     stream_type;
   guint            stream_added_handler_id;
   guint            stream_removed_handler_id;
+  GHashTable      *rows_by_id;
 };
 
 G_DEFINE_TYPE (CcStreamListBox, cc_stream_list_box, GTK_TYPE_LIST_BOX)
@@ -81,6 +82,10 @@ stream_added_cb (CcStreamListBox *self,
   if (stream == NULL)
     return;
 
+  /* Already shown */
+  if (g_hash_table_contains (self->rows_by_id, GUINT_TO_POINTER (id)))
+    return;
+
   app_id = gvc_mixer_stream_get_application_id (stream);
 
   /* Skip master volume controls */
@@ -103,28 +108,7 @@ stream_added_cb (CcStreamListBox *self,
   gtk_widget_show (GTK_WIDGET (row));
   gtk_list_box_row_set_activatable (GTK_LIST_BOX_ROW (row), FALSE);
   gtk_container_add (GTK_CONTAINER (self), GTK_WIDGET (row));
-}
-
-static CcStreamRow *
-find_row (CcStreamListBox *self,
-          guint            id)
-{
-  g_autoptr(GList) children = NULL;
-  GList *link;
-
-  children = gtk_container_get_children (GTK_CONTAINER (self));
-  for (link = children; link; link = link->next)
-    {
-      CcStreamRow *row = link->data;
-
-      if (!CC_IS_STREAM_ROW (row))
-        continue;
-
-      if (id == cc_stream_row_get_id (row))
-        return row;
-    }
-
-  return NULL;
+  g_hash_table_insert (self->rows_by_id, GUINT_TO_POINTER (id), row);
 }
 
 static void
@@ -133,9 +117,12 @@ stream_removed_cb (CcStreamListBox *self,
 {
   CcStreamRow *row;
 
-  row = find_row (self, id);
-  if (row != NULL)
-    gtk_container_remove (GTK_CONTAINER (self), GTK_WIDGET (row));
+  row = g_hash_table_lookup (self->rows_by_id, GUINT_TO_POINTER (id));
+  if (row == NULL)
+    return;
+
+  g_hash_table_remove (self->rows_by_id, GUINT_TO_POINTER (id));
+  gtk_container_remove (GTK_CONTAINER (self), GTK_WIDGET (row));
 }
 
 static void
@@ -182,6 +169,16 @@ cc_stream_list_box_dispose (GObject *object)
   G_OBJECT_CLASS (cc_stream_list_box_parent_class)->dispose (object);
 }
 
+static void
+cc_stream_list_box_finalize (GObject *object)
+{
+  CcStreamListBox *self = CC_STREAM_LIST_BOX (object);
+
+  g_clear_pointer (&self->rows_by_id, g_hash_table_unref);
+
+  G_OBJECT_CLASS (cc_stream_list_box_parent_class)->finalize (object);
+}
+
 void
 cc_stream_list_box_class_init (CcStreamListBoxClass *klass)
 {
@@ -190,6 +187,7 @@ cc_stream_list_box_class_init (CcStreamListBoxClass *klass)
   object_class->set_property = cc_stream_list_box_set_property;
   object_class->get_property = cc_stream_list_box_get_property;
   object_class->dispose = cc_stream_list_box_dispose;
+  object_class->finalize = cc_stream_list_box_finalize;
 
   g_object_class_install_property (object_class, PROP_LABEL_SIZE_GROUP,
                                    g_param_spec_object ("label-size-group",
@@ -202,6 +200,9 @@ cc_stream_list_box_class_init (CcStreamListBoxClass *klass)
 void
 cc_stream_list_box_init (CcStreamListBox *self)
 {
+  /* Stream ID → CcStreamRow, the rows are owned by the list box */
+  self->rows_by_id = g_hash_table_new (g_direct_hash, g_direct_equal);
+
   gtk_list_box_set_selection_mode (GTK_LIST_BOX (self), GTK_SELECTION_NONE);
   gtk_list_box_set_sort_func (GTK_LIST_BOX (self), sort_cb, self, NULL);
 }
@@ -92,6 +92,7 @@ struct _CcAddUserDialog {
         gboolean            has_custom_username;
         gint                local_name_timeout_id;
         gint                local_username_timeout_id;
+        GCancellable       *local_username_cancellable;
         ActUserPasswordMode local_password_mode;
         gint                local_password_timeout_id;
         gboolean            local_valid_username;
@@ -317,6 +318,9 @@ static void local_username_is_valid_cb (GObject *source_object,
         gboolean valid;
 
         valid = is_valid_username_finish (result, &tip, &username, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                return;
+
         if (error != NULL) {
                 g_warning ("Could not check username by usermod: %s", error->message);
                 valid = TRUE;
@@ -337,8 +341,14 @@ local_username_timeout (CcAddUserDialog *self)
 
         self->local_username_timeout_id = 0;
 
+        /* Only the check for the latest name matters */
+        g_cancellable_cancel (self->local_username_cancellable);
+        g_clear_object (&self->local_username_cancellable);
+        self->local_username_cancellable = g_cancellable_new ();
+
         name = gtk_combo_box_text_get_active_text (self->local_username_combo);
-        is_valid_username_async (name, NULL, local_username_is_valid_cb, g_object_ref (self));
+        is_valid_username_async (name, self->local_username_cancellable,
+                                 local_username_is_valid_cb, g_object_ref (self));
 
         return FALSE;
 }
@@ -372,6 +382,7 @@ local_username_combo_changed_cb (CcAddUserDialog *self)
                 g_source_remove (self->local_username_timeout_id);
                 self->local_username_timeout_id = 0;
         }
+        g_cancellable_cancel (self->local_username_cancellable);
 
         clear_entry_validation_error (self->local_username_entry);
         gtk_widget_set_sensitive (GTK_WIDGET (self->add_button), FALSE);
@@ -1505,6 +1516,9 @@ cc_add_user_dialog_init (CcAddUserDialog *self)
 
         self->cancellable = g_cancellable_new ();
 
+        /* Users may have been added or removed since the last dialog */
+        clear_username_cache ();
+
         self->local_password_mode = ACT_USER_PASSWORD_MODE_SET_AT_LOGIN;
         dialog_validate (self);
         update_password_strength (self);
@@ -1603,6 +1617,9 @@ cc_add_user_dialog_dispose (GObject *obj)
                 self->local_username_timeout_id = 0;
         }
 
+        g_cancellable_cancel (self->local_username_cancellable);
+        g_clear_object (&self->local_username_cancellable);
+
         if (self->enterprise_domain_timeout_id != 0) {
                 g_source_remove (self->enterprise_domain_timeout_id);
                 self->enterprise_domain_timeout_id = 0;
@@ -62,12 +62,87 @@ struct _CcAvatarChooser {
 
         GnomeDesktopThumbnailFactory *thumb_factory;
         GListStore *faces;
+        GCancellable *faces_cancellable;
 
         ActUser *user;
 };
 
 G_DEFINE_TYPE (CcAvatarChooser, cc_avatar_chooser, GTK_TYPE_POPOVER)
 
+/* Rounded stock faces, shared by every chooser of the session. Entries are
+ * keyed on the path and only reused while the file's mtime and size match. */
+typedef struct {
+        guint64    mtime;
+        goffset    size;
+        GdkPixbuf *pixbuf;
+} FaceCacheEntry;
+
+static GHashTable *face_cache;
+static GMutex face_cache_mutex;
+
+static void
+face_cache_entry_free (FaceCacheEntry *entry)
+{
+        g_clear_object (&entry->pixbuf);
+        g_free (entry);
+}
+
+static GdkPixbuf *
+face_cache_lookup (const gchar *path)
+{
+        FaceCacheEntry *entry = NULL;
+        GdkPixbuf *pixbuf = NULL;
+
+        g_mutex_lock (&face_cache_mutex);
+        if (face_cache != NULL)
+                entry = g_hash_table_lookup (face_cache, path);
+        if (entry != NULL)
+                pixbuf = g_object_ref (entry->pixbuf);
+        g_mutex_unlock (&face_cache_mutex);
+
+        return pixbuf;
+}
+
+/* Called from the enumeration thread */
+static gboolean
+face_cache_load (const gchar *path,
+                 guint64      mtime,
+                 goffset      size)
+{
+        g_autoptr(GdkPixbuf) source_pixbuf = NULL;
+        FaceCacheEntry *entry;
+        gboolean cached;
+
+        g_mutex_lock (&face_cache_mutex);
+        if (face_cache == NULL)
+                face_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    g_free, (GDestroyNotify) face_cache_entry_free);
+        entry = g_hash_table_lookup (face_cache, path);
+        cached = entry != NULL && entry->mtime == mtime && entry->size == size;
+        g_mutex_unlock (&face_cache_mutex);
+
+        if (cached)
+                return TRUE;
+
+        source_pixbuf = gdk_pixbuf_new_from_file_at_size (path,
+                                                          AVATAR_CHOOSER_PIXEL_SIZE,
+                                                          AVATAR_CHOOSER_PIXEL_SIZE,
+                                                          NULL);
+        if (source_pixbuf == NULL)
+                return FALSE;
+
+        entry = g_new0 (FaceCacheEntry, 1);
+        entry->mtime = mtime;
+        entry->size = size;
+        entry->pixbuf = round_image (source_pixbuf);
+
+        g_mutex_lock (&face_cache_mutex);
+        g_hash_table_insert (face_cache, g_strdup (path), entry);
+        g_mutex_unlock (&face_cache_mutex);
+
+        return TRUE;
+}
+
 static void
 crop_dialog_response (CcAvatarChooser *self,
                       gint             response_id,
@@ -342,20 +417,26 @@ create_face_widget (gpointer item,
                     gpointer user_data)
 {
         g_autofree gchar *image_path = NULL;
-        g_autoptr(GdkPixbuf) source_pixbuf = NULL;
         g_autoptr(GdkPixbuf) pixbuf = NULL;
         GtkWidget *image;
 
         image_path = g_file_get_path (G_FILE (item));
 
-        source_pixbuf = gdk_pixbuf_new_from_file_at_size (image_path,
-                                                          AVATAR_CHOOSER_PIXEL_SIZE,
-                                                          AVATAR_CHOOSER_PIXEL_SIZE,
-                                                          NULL);
-        if (source_pixbuf == NULL)
-                return NULL;
+        /* Faces are only added to the model once they are in the cache */
+        pixbuf = face_cache_lookup (image_path);
+        if (pixbuf == NULL) {
+                g_autoptr(GdkPixbuf) source_pixbuf = NULL;
+
+                source_pixbuf = gdk_pixbuf_new_from_file_at_size (image_path,
+                                                                  AVATAR_CHOOSER_PIXEL_SIZE,
+                                                                  AVATAR_CHOOSER_PIXEL_SIZE,
+                                                                  NULL);
+                if (source_pixbuf == NULL)
+                        return NULL;
+
+                pixbuf = round_image (source_pixbuf);
+        }
 
-        pixbuf = round_image (source_pixbuf);
         image = gtk_image_new_from_pixbuf (pixbuf);
         gtk_image_set_pixel_size (GTK_IMAGE (image), AVATAR_CHOOSER_PIXEL_SIZE);
         gtk_widget_show (image);
@@ -431,10 +512,13 @@ get_system_facesdirs (void)
         return (GStrv) g_ptr_array_steal (facesdirs, NULL);
 }
 
+/* Called from the enumeration thread */
 static gboolean
-add_faces_from_dirs (GListStore *faces, GStrv facesdirs, gboolean add_all)
+add_faces_from_dirs (GPtrArray    *faces,
+                     GStrv         facesdirs,
+                     gboolean      add_all,
+                     GCancellable *cancellable)
 {
-        GFile *file;
         GFileType type;
         const gchar *target;
         guint i;
@@ -449,16 +533,21 @@ add_faces_from_dirs (GListStore *faces, GStrv facesdirs, gboolean add_all)
                 enumerator = g_file_enumerate_children (dir,
                                                         G_FILE_ATTRIBUTE_STANDARD_NAME ","
                                                         G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                                        G_FILE_ATTRIBUTE_STANDARD_SIZE ","
                                                         G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK ","
-                                                        G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET,
+                                                        G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET ","
+                                                        G_FILE_ATTRIBUTE_TIME_MODIFIED,
                                                         G_FILE_QUERY_INFO_NONE,
-                                                        NULL, NULL);
+                                                        cancellable, NULL);
                 if (enumerator == NULL) {
                         continue;
                 }
 
                 while (TRUE) {
-                        g_autoptr(GFileInfo) info = g_file_enumerator_next_file (enumerator, NULL, NULL);
+                        g_autoptr(GFileInfo) info = g_file_enumerator_next_file (enumerator, cancellable, NULL);
+                        g_autoptr(GFile) file = NULL;
+                        g_autofree gchar *path = NULL;
+
                         if (info == NULL) {
                                 break;
                         }
@@ -475,7 +564,15 @@ add_faces_from_dirs (GListStore *faces, GStrv facesdirs, gboolean add_all)
                         }
 
                         file = g_file_get_child (dir, g_file_info_get_name (info));
-                        g_list_store_append (faces, file);
+                        path = g_file_get_path (file);
+
+                        if (!face_cache_load (path,
+                                              g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED),
+                                              g_file_info_get_size (info))) {
+                                continue;
+                        }
+
+                        g_ptr_array_add (faces, g_steal_pointer (&file));
 
                         added_faces = TRUE;
                 }
@@ -488,11 +585,48 @@ add_faces_from_dirs (GListStore *faces, GStrv facesdirs, gboolean add_all)
         return added_faces;
 }
 
+static void
+load_faces_thread (GTask        *task,
+                   gpointer      source_object,
+                   gpointer      task_data,
+                   GCancellable *cancellable)
+{
+        GStrv settings_facesdirs = task_data;
+        g_autoptr(GPtrArray) faces = NULL;
+
+        faces = g_ptr_array_new_with_free_func (g_object_unref);
+
+        if (!add_faces_from_dirs (faces, settings_facesdirs, TRUE, cancellable)) {
+                g_auto(GStrv) system_facesdirs = get_system_facesdirs ();
+                add_faces_from_dirs (faces, system_facesdirs, FALSE, cancellable);
+        }
+
+        g_task_return_pointer (task, g_steal_pointer (&faces), (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+load_faces_cb (GObject      *source,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+        CcAvatarChooser *self = user_data;
+        g_autoptr(GPtrArray) faces = NULL;
+        g_autoptr(GError) error = NULL;
+
+        faces = g_task_propagate_pointer (G_TASK (result), &error);
+        if (faces == NULL) {
+                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                        g_warning ("Failed to load stock faces: %s", error->message);
+                return;
+        }
+
+        g_list_store_splice (self->faces, 0, 0, faces->pdata, faces->len);
+}
 
 static void
 setup_photo_popup (CcAvatarChooser *self)
 {
-        g_auto(GStrv) settings_facesdirs = NULL;
+        g_autoptr(GTask) task = NULL;
 
         self->faces = g_list_store_new (G_TYPE_FILE);
         gtk_flow_box_bind_model (GTK_FLOW_BOX (self->flowbox),
@@ -504,12 +638,13 @@ setup_photo_popup (CcAvatarChooser *self)
         g_signal_connect_object (self->flowbox, "child-activated",
                                  G_CALLBACK (face_widget_activated), self, G_CONNECT_SWAPPED);
 
-        settings_facesdirs = get_settings_facesdirs ();
-
-        if (!add_faces_from_dirs (self->faces, settings_facesdirs, TRUE)) {
-                g_auto(GStrv) system_facesdirs = get_system_facesdirs ();
-                add_faces_from_dirs (self->faces, system_facesdirs, FALSE);
-        }
+        /* Enumerating and decoding the faces is slow on a cold cache, so do
+         * it in a thread; the rounded faces are kept for the whole session. */
+        self->faces_cancellable = g_cancellable_new ();
+        task = g_task_new (NULL, self->faces_cancellable, load_faces_cb, self);
+        g_task_set_source_tag (task, setup_photo_popup);
+        g_task_set_task_data (task, get_settings_facesdirs (), (GDestroyNotify) g_strfreev);
+        g_task_run_in_thread (task, load_faces_thread);
 
 #ifdef HAVE_CHEESE
         gtk_widget_set_visible (self->take_picture_button, TRUE);
@@ -576,6 +711,8 @@ cc_avatar_chooser_dispose (GObject *object)
 {
         CcAvatarChooser *self = CC_AVATAR_CHOOSER (object);
 
+        g_cancellable_cancel (self->faces_cancellable);
+        g_clear_object (&self->faces_cancellable);
         g_clear_object (&self->thumb_factory);
 #ifdef HAVE_CHEESE
         g_cancellable_cancel (self->cancellable);
@@ -48,13 +48,6 @@ struct _CcCropArea {
 
 G_DEFINE_TYPE (CcCropArea, cc_crop_area, GTK_TYPE_DRAWING_AREA);
 
-static inline guchar
-shift_color_byte (guchar b,
-                  int    shift)
-{
-        return CLAMP(b + shift, 0, 255);
-}
-
 static void
 shift_colors (GdkPixbuf *pixbuf,
               gint       red,
@@ -62,7 +55,9 @@ shift_colors (GdkPixbuf *pixbuf,
               gint       blue,
               gint       alpha)
 {
-        gint x, y, offset, y_offset, rowstride, width, height;
+        gint x, y, c, i, rowstride, width, height;
+        gint shifts[4] = { red, green, blue, alpha };
+        guchar table[4][256];
         guchar *pixels;
         gint channels;
 
@@ -70,21 +65,19 @@ shift_colors (GdkPixbuf *pixbuf,
         height = gdk_pixbuf_get_height (pixbuf);
         rowstride = gdk_pixbuf_get_rowstride (pixbuf);
         pixels = gdk_pixbuf_get_pixels (pixbuf);
-        channels = gdk_pixbuf_get_n_channels (pixbuf);
+        channels = MIN (gdk_pixbuf_get_n_channels (pixbuf), 4);
+
+        /* Look up the shifted values instead of clamping every byte */
+        for (c = 0; c < channels; c++)
+                for (i = 0; i < 256; i++)
+                        table[c][i] = CLAMP (i + shifts[c], 0, 255);
 
         for (y = 0; y < height; y++) {
-                y_offset = y * rowstride;
-                for (x = 0; x < width; x++) {
-                        offset = y_offset + x * channels;
-                        if (red != 0)
-                                pixels[offset] = shift_color_byte (pixels[offset], red);
-                        if (green != 0)
-                                pixels[offset + 1] = shift_color_byte (pixels[offset + 1], green);
-                        if (blue != 0)
-                                pixels[offset + 2] = shift_color_byte (pixels[offset + 2], blue);
-                        if (alpha != 0 && channels >= 4)
-                                pixels[offset + 3] = shift_color_byte (pixels[offset + 3], blue);
-                }
+                guchar *p = pixels + y * rowstride;
+
+                for (x = 0; x < width; x++, p += channels)
+                        for (c = 0; c < channels; c++)
+                                p[c] = table[c][p[c]];
         }
 }
 
@@ -111,15 +104,16 @@ update_pixbufs (CcCropArea *area)
         dest_width = width * scale;
         dest_height = height * scale;
 
+        /* The scaled image only depends on its own size, so keep it as long
+         * as that does not change. */
         if (area->pixbuf == NULL ||
-            gdk_pixbuf_get_width (area->pixbuf) != allocation.width ||
-            gdk_pixbuf_get_height (area->pixbuf) != allocation.height) {
+            gdk_pixbuf_get_width (area->pixbuf) != dest_width ||
+            gdk_pixbuf_get_height (area->pixbuf) != dest_height) {
                 g_clear_object (&area->pixbuf);
                 area->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
                                                      gdk_pixbuf_get_has_alpha (area->browse_pixbuf),
                                                      8,
                                                      dest_width, dest_height);
-                gdk_pixbuf_fill (area->pixbuf, 0x0);
 
                 gdk_pixbuf_scale (area->browse_pixbuf,
                                   area->pixbuf,
@@ -148,13 +142,13 @@ update_pixbufs (CcCropArea *area)
                         area->crop.x = (gdk_pixbuf_get_width (area->browse_pixbuf) - area->crop.width) / 2;
                         area->crop.y = (gdk_pixbuf_get_height (area->browse_pixbuf) - area->crop.height) / 2;
                 }
-
-                area->scale = scale;
-                area->image.x = (allocation.width - dest_width) / 2;
-                area->image.y = (allocation.height - dest_height) / 2;
-                area->image.width = dest_width;
-                area->image.height = dest_height;
         }
+
+        area->scale = scale;
+        area->image.x = (allocation.width - dest_width) / 2;
+        area->image.y = (allocation.height - dest_height) / 2;
+        area->image.width = dest_width;
+        area->image.height = dest_height;
 }
 
 static void
@@ -764,6 +758,8 @@ cc_crop_area_set_picture (CcCropArea *area,
         int height;
 
         g_clear_object (&area->browse_pixbuf);
+        g_clear_object (&area->pixbuf);
+        g_clear_object (&area->color_shifted);
         if (pixbuf) {
                 area->browse_pixbuf = g_object_ref (pixbuf);
                 width = gdk_pixbuf_get_width (pixbuf);
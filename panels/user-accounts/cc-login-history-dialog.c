@@ -48,14 +48,18 @@ struct _CcLoginHistoryDialog
         GDateTime    *current_week;
 
         ActUser      *user;
+
+        /* Sorted by login time, parsed from the user's LoginHistory */
+        GArray       *login_history;
+        gboolean      login_history_in_order;
 };
 
 G_DEFINE_TYPE (CcLoginHistoryDialog, cc_login_history_dialog, GTK_TYPE_DIALOG)
 
 typedef struct {
-	gint64 login_time;
-	gint64 logout_time;
-	const gchar *type;
+        gint64   login_time;
+        gint64   logout_time;
+        gboolean session;
 } CcLoginHistory;
 
 static void
@@ -111,47 +115,129 @@ clear_history (CcLoginHistoryDialog *self)
         }
 }
 
-static GArray *
-get_login_history (ActUser *user)
+static void
+parse_login_history_entry (GVariant       *value,
+                           gsize           index,
+                           CcLoginHistory *history)
+{
+        g_autoptr(GVariant) details = NULL;
+        const gchar *type = NULL;
+
+        g_variant_get_child (value, index, "(xx@a{sv})",
+                             &history->login_time, &history->logout_time, &details);
+        g_variant_lookup (details, "type", "&s", &type);
+
+        /* Display only x-session and tty records */
+        history->session = type != NULL &&
+                           (g_str_has_prefix (type, ":") || g_str_has_prefix (type, "tty"));
+}
+
+static gboolean
+login_history_entry_unchanged (GVariant       *value,
+                               gsize           index,
+                               CcLoginHistory *history)
 {
-	GArray *login_history;
-	GVariantIter *iter, *iter2;
-	GVariant *variant;
-	const GVariant *value;
-	const gchar *key;
-	CcLoginHistory history;
-
-	login_history = NULL;
-	value = act_user_get_login_history (user);
-	g_variant_get ((GVariant *) value, "a(xxa{sv})", &iter);
-	while (g_variant_iter_loop (iter, "(xxa{sv})", &history.login_time, &history.logout_time, &iter2)) {
-		while (g_variant_iter_loop (iter2, "{&sv}", &key, &variant)) {
-			if (g_strcmp0 (key, "type") == 0) {
-				history.type = g_variant_get_string (variant, NULL);
-			}
-		}
-
-		if (login_history == NULL) {
-			login_history = g_array_new (FALSE, TRUE, sizeof (CcLoginHistory));
-		}
-
-		g_array_append_val (login_history, history);
-	}
-
-	return login_history;
+        gint64 login_time, logout_time;
+
+        g_variant_get_child (value, index, "(xx*)", &login_time, &logout_time, NULL);
+
+        return login_time == history->login_time && logout_time == history->logout_time;
+}
+
+static gint
+compare_login_time (gconstpointer a,
+                    gconstpointer b)
+{
+        const CcLoginHistory *ha = a;
+        const CcLoginHistory *hb = b;
+
+        return (ha->login_time > hb->login_time) - (ha->login_time < hb->login_time);
+}
+
+static void
+update_login_history (CcLoginHistoryDialog *self)
+{
+        GVariant *value;
+        gsize n_children, n_keep, i;
+
+        value = (GVariant *) act_user_get_login_history (self->user);
+        if (value == NULL || !g_variant_is_of_type (value, G_VARIANT_TYPE ("a(xxa{sv})"))) {
+                g_array_set_size (self->login_history, 0);
+                self->login_history_in_order = TRUE;
+                return;
+        }
+
+        /* Records are only ever appended, and a record only changes when
+         * its session ends and the logout time gets filled in. Sessions
+         * overlap, so that can be any record still open, not just the
+         * last one: keep the records before the earliest open session and
+         * parse everything from there on. */
+        n_children = g_variant_n_children (value);
+        n_keep = 0;
+        if (self->login_history_in_order) {
+                while (n_keep < self->login_history->len &&
+                       g_array_index (self->login_history, CcLoginHistory, n_keep).logout_time != 0)
+                        n_keep++;
+                n_keep = MIN (n_keep, n_children);
+
+                /* Start over if the history was replaced rather than extended */
+                if (n_keep > 0 &&
+                    (!login_history_entry_unchanged (value, 0, &g_array_index (self->login_history, CcLoginHistory, 0)) ||
+                     !login_history_entry_unchanged (value, n_keep - 1,
+                                                     &g_array_index (self->login_history, CcLoginHistory, n_keep - 1))))
+                        n_keep = 0;
+        }
+
+        g_array_set_size (self->login_history, n_keep);
+        if (n_keep == 0)
+                self->login_history_in_order = TRUE;
+
+        for (i = n_keep; i < n_children; i++) {
+                CcLoginHistory history;
+
+                parse_login_history_entry (value, i, &history);
+
+                if (self->login_history->len > 0 &&
+                    history.login_time < g_array_index (self->login_history, CcLoginHistory, self->login_history->len - 1).login_time)
+                        self->login_history_in_order = FALSE;
+
+                g_array_append_val (self->login_history, history);
+        }
+
+        /* Indices no longer match the variant once sorted, so the next
+         * update has to start over */
+        if (!self->login_history_in_order)
+                g_array_sort (self->login_history, compare_login_time);
+}
+
+/* Returns the index of the first record logged in at or after @time */
+static guint
+find_login_history_index (GArray *login_history,
+                          gint64  time)
+{
+        guint low = 0, high = login_history->len;
+
+        while (low < high) {
+                guint mid = low + (high - low) / 2;
+
+                if (g_array_index (login_history, CcLoginHistory, mid).login_time < time)
+                        low = mid + 1;
+                else
+                        high = mid;
+        }
+
+        return low;
 }
 
 static void
 set_sensitivity (CcLoginHistoryDialog *self)
 {
-        g_autoptr(GArray) login_history = NULL;
-        CcLoginHistory history;
+        CcLoginHistory *history;
         gboolean sensitive = FALSE;
 
-        login_history = get_login_history (self->user);
-        if (login_history != NULL) {
-                history = g_array_index (login_history, CcLoginHistory, 0);
-                sensitive = g_date_time_to_unix (self->week) > history.login_time;
+        if (self->login_history->len > 0) {
+                history = &g_array_index (self->login_history, CcLoginHistory, 0);
+                sensitive = g_date_time_to_unix (self->week) > history->login_time;
         }
         gtk_widget_set_sensitive (GTK_WIDGET (self->previous_button), sensitive);
 
@@ -196,62 +282,58 @@ add_record (CcLoginHistoryDialog *self, GDateTime *datetime, gchar *record_strin
 static void
 show_week (CcLoginHistoryDialog *self)
 {
-        g_autoptr(GArray) login_history = NULL;
         g_autoptr(GDateTime) datetime = NULL;
         g_autoptr(GDateTime) temp = NULL;
         gint64 from, to;
         gint i, line;
-        CcLoginHistory history;
+        CcLoginHistory *history;
 
         show_week_label (self);
         clear_history (self);
         set_sensitivity (self);
 
-        login_history = get_login_history (self->user);
-        if (login_history == NULL) {
-                return;
-        }
-
-        /* Find first record for week */
+        /* Find last record started before the end of the week */
         from = g_date_time_to_unix (self->week);
         temp = g_date_time_add_weeks (self->week, 1);
         to = g_date_time_to_unix (temp);
-        for (i = login_history->len - 1; i >= 0; i--) {
-                history = g_array_index (login_history, CcLoginHistory, i);
-                if (history.login_time < to) {
-                        break;
-                }
-        }
+        i = (gint) find_login_history_index (self->login_history, to) - 1;
 
         /* Add new session records */
         line = 0;
         for (;i >= 0; i--) {
-                history = g_array_index (login_history, CcLoginHistory, i);
+                history = &g_array_index (self->login_history, CcLoginHistory, i);
 
-                /* Display only x-session and tty records */
-                if (!g_str_has_prefix (history.type, ":") &&
-                    !g_str_has_prefix (history.type, "tty")) {
+                if (!history->session) {
                         continue;
                 }
 
-                if (history.logout_time > 0 && history.logout_time < from) {
+                if (history->logout_time > 0 && history->logout_time < from) {
                         break;
                 }
 
-                if (history.logout_time > 0 && history.logout_time < to) {
-                        datetime = g_date_time_new_from_unix_local (history.logout_time);
+                if (history->logout_time > 0 && history->logout_time < to) {
+                        g_clear_pointer (&datetime, g_date_time_unref);
+                        datetime = g_date_time_new_from_unix_local (history->logout_time);
                         add_record (self, datetime, _("Session Ended"), line);
                         line++;
                 }
 
-                if (history.login_time >= from) {
-                        datetime = g_date_time_new_from_unix_local (history.login_time);
+                if (history->login_time >= from) {
+                        g_clear_pointer (&datetime, g_date_time_unref);
+                        datetime = g_date_time_new_from_unix_local (history->login_time);
                         add_record (self, datetime, _("Session Started"), line);
                         line++;
                 }
         }
 }
 
+static void
+user_changed_cb (CcLoginHistoryDialog *self)
+{
+        update_login_history (self);
+        show_week (self);
+}
+
 static void
 previous_button_clicked_cb (CcLoginHistoryDialog *self)
 {
@@ -280,6 +362,7 @@ cc_login_history_dialog_dispose (GObject *object)
         CcLoginHistoryDialog *self = CC_LOGIN_HISTORY_DIALOG (object);
 
         g_clear_object (&self->user);
+        g_clear_pointer (&self->login_history, g_array_unref);
         g_clear_pointer (&self->week, g_date_time_unref);
         g_clear_pointer (&self->current_week, g_date_time_unref);
 
@@ -311,6 +394,9 @@ cc_login_history_dialog_init (CcLoginHistoryDialog *self)
         g_resources_register (cc_user_accounts_get_resource ());
 
         gtk_widget_init_template (GTK_WIDGET (self));
+
+        self->login_history = g_array_new (FALSE, FALSE, sizeof (CcLoginHistory));
+        self->login_history_in_order = TRUE;
 }
 
 CcLoginHistoryDialog *
@@ -344,6 +430,10 @@ cc_login_history_dialog_new (ActUser *user)
                                  act_user_get_real_name (self->user));
         gtk_header_bar_set_title (self->header_bar, title);
 
+        update_login_history (self);
+        g_signal_connect_object (self->user, "changed",
+                                 G_CALLBACK (user_changed_cb), self, G_CONNECT_SWAPPED);
+
         show_week (self);
 
         return self;
@@ -42,6 +42,9 @@
 
 #define IMAGE_SIZE 512
 
+/* How long, in seconds, the result of a username lookup is trusted */
+#define USERNAME_CACHE_TIMEOUT 30
+
 typedef struct {
         gchar *text;
         gchar *placeholder_str;
@@ -344,16 +347,85 @@ get_username_max_length (void)
         return sizeof (((struct utmpx *)NULL)->ut_user);
 }
 
+/* Lookups can go through NSS to LDAP or SSSD, and usermod has to be
+ * spawned for every check, so remember the answers for a short while. */
+typedef struct {
+        gint64    timestamp;
+        gboolean  result;
+        gchar    *tip;
+} UsernameCacheEntry;
+
+static GHashTable *username_used_cache;
+static GHashTable *username_valid_cache;
+
+static void
+username_cache_entry_free (UsernameCacheEntry *entry)
+{
+        g_free (entry->tip);
+        g_free (entry);
+}
+
+static UsernameCacheEntry *
+username_cache_lookup (GHashTable  *cache,
+                       const gchar *username)
+{
+        UsernameCacheEntry *entry;
+
+        if (cache == NULL)
+                return NULL;
+
+        entry = g_hash_table_lookup (cache, username);
+        if (entry != NULL &&
+            g_get_monotonic_time () - entry->timestamp > USERNAME_CACHE_TIMEOUT * G_USEC_PER_SEC) {
+                g_hash_table_remove (cache, username);
+                return NULL;
+        }
+
+        return entry;
+}
+
+static void
+username_cache_insert (GHashTable  **cache,
+                       const gchar  *username,
+                       gboolean      result,
+                       const gchar  *tip)
+{
+        UsernameCacheEntry *entry;
+
+        if (*cache == NULL)
+                *cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, (GDestroyNotify) username_cache_entry_free);
+
+        entry = g_new0 (UsernameCacheEntry, 1);
+        entry->timestamp = g_get_monotonic_time ();
+        entry->result = result;
+        entry->tip = g_strdup (tip);
+        g_hash_table_insert (*cache, g_strdup (username), entry);
+}
+
+void
+clear_username_cache (void)
+{
+        g_clear_pointer (&username_used_cache, g_hash_table_unref);
+        g_clear_pointer (&username_valid_cache, g_hash_table_unref);
+}
+
 gboolean
 is_username_used (const gchar *username)
 {
+        UsernameCacheEntry *entry;
         struct passwd *pwent;
 
         if (username == NULL || username[0] == '\0') {
                 return FALSE;
         }
 
+        entry = username_cache_lookup (username_used_cache, username);
+        if (entry != NULL)
+                return entry->result;
+
         pwent = getpwnam (username);
+        username_cache_insert (&username_used_cache, username, pwent != NULL, NULL);
 
         return pwent != NULL;
 }
@@ -412,6 +484,43 @@ is_valid_username_data_free (isValidUsernameData *data)
 #define E_NOTFOUND 6
 #endif
 
+static const gchar *
+get_invalid_username_tip (void)
+{
+        return _("The username should usually only consist of lower case letters from a-z, digits and the following characters: - _");
+}
+
+static const gchar *
+get_used_username_tip (void)
+{
+        return _("Sorry, that user name isn’t available. Please try another.");
+}
+
+/* Rejects only what no passwd implementation accepts, even with relaxed
+ * naming rules, so usermod remains the authority for everything else. */
+static gboolean
+is_username_syntax_valid (const gchar *username)
+{
+        const gchar *c;
+        gboolean all_digits = TRUE;
+
+        if (username[0] == '-' ||
+            g_strcmp0 (username, ".") == 0 ||
+            g_strcmp0 (username, "..") == 0)
+                return FALSE;
+
+        for (c = username; *c != '\0'; c++) {
+                if (*c == ':' || *c == ',' || *c == '/' ||
+                    g_ascii_isspace (*c) || g_ascii_iscntrl (*c))
+                        return FALSE;
+
+                if (!g_ascii_isdigit (*c))
+                        all_digits = FALSE;
+        }
+
+        return !all_digits;
+}
+
 static void
 is_valid_username_child_watch_cb (GPid pid,
                                   gint status,
@@ -429,17 +538,18 @@ is_valid_username_child_watch_cb (GPid pid,
                                 valid = TRUE;
                                 break;
                         case E_BAD_ARG:
-                                tip = _("The username should usually only consist of lower case letters from a-z, digits and the following characters: - _");
+                                tip = get_invalid_username_tip ();
                                 valid = FALSE;
                                 break;
                         case E_SUCCESS:
-                                tip = _("Sorry, that user name isn’t available. Please try another.");
+                                tip = get_used_username_tip ();
                                 valid = FALSE;
                                 break;
                 }
         }
 
         if (valid || tip != NULL) {
+                username_cache_insert (&username_valid_cache, data->username, valid, tip);
                 data->tip = g_strdup (tip);
                 g_task_return_boolean (task, valid);
         }
@@ -459,6 +569,7 @@ is_valid_username_async (const gchar *username,
 {
         g_autoptr(GTask) task = NULL;
         isValidUsernameData *data;
+        UsernameCacheEntry *entry;
         gchar *argv[6];
         GPid pid;
         GError *error = NULL;
@@ -479,6 +590,23 @@ is_valid_username_async (const gchar *username,
                 g_task_return_boolean (task, FALSE);
                 return;
         }
+        else if (!is_username_syntax_valid (username)) {
+                data->tip = g_strdup (get_invalid_username_tip ());
+                g_task_return_boolean (task, FALSE);
+                return;
+        }
+        else if (is_username_used (username)) {
+                data->tip = g_strdup (get_used_username_tip ());
+                g_task_return_boolean (task, FALSE);
+                return;
+        }
+
+        entry = username_cache_lookup (username_valid_cache, username);
+        if (entry != NULL) {
+                data->tip = g_strdup (entry->tip);
+                g_task_return_boolean (task, entry->result);
+                return;
+        }
 
 #ifdef __FreeBSD__
         /* Abuse "pw usershow -n <name>" in the same way as the code below. We
@@ -10,6 +10,7 @@ import dbus.service
 import dbus.mainloop.glib
 import random
 import collections
+import time
 import uuid
 
 mainloop = GLib.MainLoop()
@@ -403,7 +404,7 @@ PP_STRENGTH = "Strength"
 class WifiAp(ExportedObj):
     counter = 0
 
-    def __init__(self, bus, ssid, mac, flags, wpaf, rsnf, freq):
+    def __init__(self, bus, ssid, mac, flags, wpaf, rsnf, freq, strength=None):
         path = "/org/freedesktop/NetworkManager/AccessPoint/%d" % WifiAp.counter
         WifiAp.counter = WifiAp.counter + 1
 
@@ -416,8 +417,13 @@ class WifiAp(ExportedObj):
         self.wpaf = wpaf
         self.rsnf = rsnf
         self.freq = freq
-        self.strength = random.randint(0, 100)
-        self.strength_id = GLib.timeout_add_seconds(10, self.strength_cb, None)
+        if strength is None:
+            self.strength = random.randint(0, 100)
+            self.strength_id = GLib.timeout_add_seconds(10, self.strength_cb, None)
+        else:
+            # Scripted APs only change when told to
+            self.strength = strength
+            self.strength_id = 0
 
         self.add_dbus_interface(IFACE_WIFI_AP, self.__get_props, WifiAp.PropertiesChanged)
         ExportedObj.__init__(self, bus, path)
@@ -432,6 +438,18 @@ class WifiAp(ExportedObj):
         self.__notify(PP_STRENGTH)
         return True
 
+    def set_strength(self, strength):
+        # Scripted APs stop changing on their own
+        if self.strength_id > 0:
+            GLib.source_remove(self.strength_id)
+            self.strength_id = 0
+        self.strength = strength
+        self.__notify(PP_STRENGTH)
+
+    def set_ssid(self, ssid):
+        self.ssid = ssid
+        self.__notify(PP_SSID)
+
     # Properties interface
     def __get_props(self):
         props = {}
@@ -466,12 +484,14 @@ PW_BITRATE = "Bitrate"
 PW_ACCESS_POINTS = "AccessPoints"
 PW_ACTIVE_ACCESS_POINT = "ActiveAccessPoint"
 PW_WIRELESS_CAPABILITIES = "WirelessCapabilities"
+PW_LAST_SCAN = "LastScan"
 
 class WifiDevice(Device):
     def __init__(self, bus, iface):
         self.mac = random_mac()
         self.aps = []
         self.active_ap = None
+        self.last_scan = -1
 
         self.add_dbus_interface(IFACE_WIFI, self.__get_props, WifiDevice.PropertiesChanged)
         Device.__init__(self, bus, iface, NM_DEVICE_TYPE_WIFI)
@@ -489,7 +509,10 @@ class WifiDevice(Device):
 
     @dbus.service.method(dbus_interface=IFACE_WIFI, in_signature='a{sv}', out_signature='')
     def RequestScan(self, props):
-        pass
+        # Scans finish right away, in CLOCK_BOOTTIME milliseconds like NM;
+        # always change it so that back-to-back scans are seen as such
+        self.last_scan = max(int(time.clock_gettime(time.CLOCK_BOOTTIME) * 1000), self.last_scan + 1)
+        self.__notify(PW_LAST_SCAN)
 
     @dbus.service.signal(IFACE_WIFI, signature='o')
     def AccessPointAdded(self, ap_path):
@@ -519,6 +542,7 @@ class WifiDevice(Device):
         props[PW_WIRELESS_CAPABILITIES] = dbus.UInt32(0xFF)
         props[PW_ACCESS_POINTS] = to_path_array(self.aps)
         props[PW_ACTIVE_ACCESS_POINT] = to_path(self.active_ap)
+        props[PW_LAST_SCAN] = dbus.Int64(self.last_scan)
         return props
 
     def __notify(self, propname):
@@ -534,6 +558,16 @@ class WifiDevice(Device):
         self.add_ap(ap)
         return ap
 
+    def add_test_aps(self, ssid_prefix, count):
+        # Only notify the AP list once for the whole batch; the APs are
+        # scripted so that tests can predict their strength
+        aps = [WifiAp(self._bus, "%s%d" % (ssid_prefix, i), None, 0x1, 0x1cc, 0x1cc, 2412, 50) for i in range(count)]
+        self.aps.extend(aps)
+        self.__notify(PW_ACCESS_POINTS)
+        for ap in aps:
+            self.AccessPointAdded(to_path(ap))
+        return aps
+
     def remove_ap_by_path(self, path):
         for ap in self.aps:
             if ap.path == path:
@@ -541,6 +575,12 @@ class WifiDevice(Device):
                 return
         raise ApNotFoundException("AP %s not found" % path)
 
+    def get_ap_by_path(self, path):
+        for ap in self.aps:
+            if ap.path == path:
+                return ap
+        raise ApNotFoundException("AP %s not found" % path)
+
 
 ###################################################################
 IFACE_WIMAX_NSP = 'org.freedesktop.NetworkManager.WiMax.Nsp'
@@ -1018,6 +1058,42 @@ class NetworkManager(ExportedObj):
                 return
         raise UnknownDeviceException("Device not found")
 
+    @dbus.service.method(IFACE_TEST, in_signature='ssu', out_signature='ao')
+    def AddWifiAps(self, ifname, ssid_prefix, count):
+        for d in self.devices:
+            if d.iface == ifname:
+                return to_path_array(d.add_test_aps(ssid_prefix, count))
+        raise UnknownDeviceException("Device not found")
+
+    @dbus.service.method(IFACE_TEST, in_signature='sou', out_signature='')
+    def SetWifiApStrength(self, ifname, ap_path, strength):
+        for d in self.devices:
+            if d.iface == ifname:
+                d.get_ap_by_path(ap_path).set_strength(strength)
+                return
+        raise UnknownDeviceException("Device not found")
+
+    @dbus.service.method(IFACE_TEST, in_signature='sos', out_signature='')
+    def SetWifiApSsid(self, ifname, ap_path, ssid):
+        for d in self.devices:
+            if d.iface == ifname:
+                d.get_ap_by_path(ap_path).set_ssid(ssid)
+                return
+        raise UnknownDeviceException("Device not found")
+
+    @dbus.service.method(IFACE_TEST, in_signature='su', out_signature='a{oy}')
+    def RandomizeWifiApStrengths(self, ifname, seed):
+        # Changes the strength of every single AP and returns the new ones
+        rand = random.Random(seed)
+        for d in self.devices:
+            if d.iface == ifname:
+                strengths = dbus.Dictionary({}, signature='oy')
+                for ap in d.aps:
+                    ap.set_strength((ap.strength + rand.randint(1, 100)) % 101)
+                    strengths[to_path(ap)] = dbus.Byte(ap.strength)
+                return strengths
+        raise UnknownDeviceException("Device not found")
+
     @dbus.service.method(IFACE_TEST, in_signature='ss', out_signature='o')
     def AddWimaxNsp(self, ifname, name):
         for d in self.devices:
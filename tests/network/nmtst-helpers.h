@@ -81,6 +81,10 @@ typedef struct {
 	const gchar * const *client_props;
 	const gchar * const *device_props;
 
+	/* AP path -> NMAccessPoint and NMAccessPoint -> expected strength */
+	GHashTable *aps;
+	GHashTable *ap_strengths;
+
 	int client_remaining;
 	int device_remaining;
 	int connection_remaining;
@@ -359,3 +363,206 @@ nmtst_add_and_activate_connection (NMTstcServiceInfo *sinfo, NMClient *client, N
 
 	return info.ac;
 }
+
+/* The following helpers do not block on the D-Bus call, so that the main loop
+ * keeps running while the mock service is busy. */
+static void
+test_call_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+	EventWaitInfo *info = user_data;
+	GError *error = NULL;
+	GVariant *ret;
+
+	ret = g_dbus_proxy_call_finish (G_DBUS_PROXY (object), result, &error);
+	g_assert_no_error (error);
+	g_variant_unref (ret);
+
+	info->other_remaining--;
+	WAIT_CHECK_REMAINING()
+}
+
+static void
+nmtst_add_wifi_aps (NMTstcServiceInfo *sinfo, NMDevice *device, const gchar *ssid_prefix, guint count)
+{
+	WAIT_DECL()
+
+	g_debug ("Adding %u APs with SSID prefix %s to device %s", count, ssid_prefix, nm_device_get_iface (device));
+
+	g_dbus_proxy_call (sinfo->proxy,
+	                   "AddWifiAps",
+	                   g_variant_new ("(ssu)", nm_device_get_iface (device), ssid_prefix, count),
+	                   G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                   30000,
+	                   NULL,
+	                   test_call_cb,
+	                   &info);
+
+	info.other_remaining = 1;
+	WAIT_DEVICE(device, count, "access-point-added")
+	WAIT_FINISHED(30)
+}
+
+static void
+ap_strength_notify_cb (NMAccessPoint *ap, GParamSpec *pspec, gpointer user_data)
+{
+	EventWaitInfo *info = user_data;
+	gpointer strength;
+
+	/* Nothing to compare with until the mock replied */
+	if (!info->ap_strengths ||
+	    !g_hash_table_lookup_extended (info->ap_strengths, ap, NULL, &strength))
+		return;
+
+	if (nm_access_point_get_strength (ap) != GPOINTER_TO_UINT (strength))
+		return;
+
+	g_hash_table_remove (info->ap_strengths, ap);
+
+	info->other_remaining--;
+	WAIT_CHECK_REMAINING()
+}
+
+static void
+randomize_wifi_ap_strengths_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+	EventWaitInfo *info = user_data;
+	GError *error = NULL;
+	GVariant *ret;
+	GVariantIter *iter;
+	const gchar *path;
+	guint8 strength;
+
+	ret = g_dbus_proxy_call_finish (G_DBUS_PROXY (object), result, &error);
+	g_assert_no_error (error);
+
+	/* Only wait for the APs that did not get their new strength yet */
+	info->ap_strengths = g_hash_table_new (NULL, NULL);
+	g_variant_get (ret, "(a{oy})", &iter);
+	while (g_variant_iter_next (iter, "{&oy}", &path, &strength)) {
+		NMAccessPoint *ap = g_hash_table_lookup (info->aps, path);
+
+		g_assert (ap != NULL);
+		if (nm_access_point_get_strength (ap) != strength)
+			g_hash_table_insert (info->ap_strengths, ap, GUINT_TO_POINTER (strength));
+	}
+	g_variant_iter_free (iter);
+	g_variant_unref (ret);
+
+	info->other_remaining = g_hash_table_size (info->ap_strengths);
+	WAIT_CHECK_REMAINING()
+}
+
+static void
+nmtst_randomize_wifi_ap_strengths (NMTstcServiceInfo *sinfo, NMDevice *device, guint seed)
+{
+	const GPtrArray *device_aps;
+	GHashTableIter iter;
+	NMAccessPoint *ap;
+	guint i;
+	WAIT_DECL()
+
+	/* Keep the APs alive for disconnecting the handlers again */
+	device_aps = nm_device_wifi_get_access_points (NM_DEVICE_WIFI (device));
+	info.aps = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	for (i = 0; i < device_aps->len; i++) {
+		ap = g_object_ref (g_ptr_array_index (device_aps, i));
+		g_hash_table_insert (info.aps, (gpointer) nm_object_get_path (NM_OBJECT (ap)), ap);
+		g_signal_connect (ap, "notify::" NM_ACCESS_POINT_STRENGTH,
+		                  G_CALLBACK (ap_strength_notify_cb), &info);
+	}
+
+	g_debug ("Changing the strength of %u APs on device %s", device_aps->len, nm_device_get_iface (device));
+
+	/* The mock changes the strength of every AP and returns the new values.
+	 * Wait for the reply first, then for every AP to have its new strength,
+	 * which may already be the case by the time the reply arrives. */
+	g_dbus_proxy_call (sinfo->proxy,
+	                   "RandomizeWifiApStrengths",
+	                   g_variant_new ("(su)", nm_device_get_iface (device), seed),
+	                   G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                   30000,
+	                   NULL,
+	                   randomize_wifi_ap_strengths_cb,
+	                   &info);
+
+	info.other_remaining = 1;
+	WAIT_FINISHED(30)
+
+	g_hash_table_iter_init (&iter, info.aps);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &ap))
+		g_signal_handlers_disconnect_by_func (ap, ap_strength_notify_cb, &info);
+	g_hash_table_unref (info.ap_strengths);
+	g_hash_table_unref (info.aps);
+}
+
+static void
+nmtst_set_wifi_ap_strength (NMTstcServiceInfo *sinfo, NMDevice *device, NMAccessPoint *ap, guint8 strength)
+{
+	GError *error = NULL;
+	GVariant *ret;
+	WAIT_DECL()
+
+	g_debug ("Setting AP %s strength to %u", nm_object_get_path (NM_OBJECT (ap)), strength);
+
+	ret = g_dbus_proxy_call_sync (sinfo->proxy,
+	                              "SetWifiApStrength",
+	                              g_variant_new ("(sou)", nm_device_get_iface (device), nm_object_get_path (NM_OBJECT (ap)), strength),
+	                              G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                              3000,
+	                              NULL,
+	                              &error);
+	g_assert_no_error (error);
+	g_variant_unref (ret);
+
+	if (nm_access_point_get_strength (ap) == strength)
+		return;
+
+	info.ap_strengths = g_hash_table_new (NULL, NULL);
+	g_hash_table_insert (info.ap_strengths, ap, GUINT_TO_POINTER (strength));
+	info.other_remaining = 1;
+	g_signal_connect (ap, "notify::" NM_ACCESS_POINT_STRENGTH,
+	                  G_CALLBACK (ap_strength_notify_cb), &info);
+
+	WAIT_FINISHED(5)
+
+	g_signal_handlers_disconnect_by_func (ap, ap_strength_notify_cb, &info);
+	g_hash_table_unref (info.ap_strengths);
+}
+
+static void
+ap_ssid_notify_cb (NMAccessPoint *ap, GParamSpec *pspec, gpointer user_data)
+{
+	EventWaitInfo *info = user_data;
+
+	info->other_remaining--;
+	WAIT_CHECK_REMAINING()
+}
+
+static void
+nmtst_set_wifi_ap_ssid (NMTstcServiceInfo *sinfo, NMDevice *device, NMAccessPoint *ap, const gchar *ssid)
+{
+	GError *error = NULL;
+	GVariant *ret;
+	WAIT_DECL()
+
+	g_debug ("Setting AP %s SSID to %s", nm_object_get_path (NM_OBJECT (ap)), ssid);
+
+	/* Only this changes the SSID of an AP in the mock */
+	info.other_remaining = 1;
+	g_signal_connect (ap, "notify::" NM_ACCESS_POINT_SSID,
+	                  G_CALLBACK (ap_ssid_notify_cb), &info);
+
+	ret = g_dbus_proxy_call_sync (sinfo->proxy,
+	                              "SetWifiApSsid",
+	                              g_variant_new ("(sos)", nm_device_get_iface (device), nm_object_get_path (NM_OBJECT (ap)), ssid),
+	                              G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                              3000,
+	                              NULL,
+	                              &error);
+	g_assert_no_error (error);
+	g_variant_unref (ret);
+
+	WAIT_FINISHED(5)
+
+	g_signal_handlers_disconnect_by_func (ap, ap_ssid_notify_cb, &info);
+}
@@ -37,6 +37,9 @@
 
 #include "cc-test-window.h"
 #include "shell/cc-object-storage.h"
+#include "cc-wifi-connection-list.h"
+#include "cc-wifi-connection-row.h"
+#include "net-device-wifi.h"
 
 #include "nmtst-helpers.h"
 
@@ -45,6 +48,7 @@ typedef struct {
   NMClient *client;
 
   NMDevice *main_ether;
+  NMDevice *main_wifi;
 
   GtkWidget *shell;
   CcPanel *panel;
@@ -52,10 +56,11 @@ typedef struct {
 
 
 extern GType cc_network_panel_get_type (void);
+extern GType cc_wifi_panel_get_type (void);
 
 static void
-fixture_set_up_empty (NetworkPanelFixture  *fixture,
-                      gconstpointer         user_data)
+fixture_set_up_panel (NetworkPanelFixture  *fixture,
+                      GType                 panel_type)
 {
   g_autoptr(GError) error = NULL;
 
@@ -72,7 +77,7 @@ fixture_set_up_empty (NetworkPanelFixture  *fixture,
 
   fixture->shell = GTK_WIDGET (cc_test_window_new ());
 
-  fixture->panel = g_object_new (cc_network_panel_get_type (),
+  fixture->panel = g_object_new (panel_type,
                                  "shell", CC_SHELL (fixture->shell),
                                  NULL);
 
@@ -82,6 +87,13 @@ fixture_set_up_empty (NetworkPanelFixture  *fixture,
   gtk_widget_show (GTK_WIDGET (fixture->shell));
 }
 
+static void
+fixture_set_up_empty (NetworkPanelFixture  *fixture,
+                      gconstpointer         user_data)
+{
+  fixture_set_up_panel (fixture, cc_network_panel_get_type ());
+}
+
 static void
 fixture_tear_down (NetworkPanelFixture  *fixture,
                    gconstpointer         user_data)
@@ -118,6 +130,18 @@ fixture_set_up_wired (NetworkPanelFixture  *fixture,
   nmtst_remove_device (fixture->sinfo, fixture->client, second);
 }
 
+static void
+fixture_set_up_wifi (NetworkPanelFixture  *fixture,
+                     gconstpointer         user_data)
+{
+  fixture_set_up_panel (fixture, cc_wifi_panel_get_type ());
+
+  fixture->main_wifi = nmtstc_service_add_device (fixture->sinfo,
+                                                  fixture->client,
+                                                  "AddWifiDevice",
+                                                  "wlan1000");
+}
+
 /*****************************************************************************/
 
 static GtkWidget *
@@ -158,6 +182,29 @@ find_label (GtkWidget   *widget,
   return label;
 }
 
+static GtkWidget *
+find_widget_of_type (GtkWidget *widget,
+                     GType      type)
+{
+  GtkWidget *found = NULL;
+
+  if (G_TYPE_CHECK_INSTANCE_TYPE (widget, type))
+    return widget;
+
+  if (GTK_IS_CONTAINER (widget)) {
+    g_autoptr(GList) list = gtk_container_get_children (GTK_CONTAINER (widget));
+    GList *node;
+
+    for (node = list; node; node = node->next) {
+      found = find_widget_of_type (node->data, type);
+      if (found)
+        break;
+    }
+  }
+
+  return found;
+}
+
 /*****************************************************************************/
 
 #if 0  /* See /network-panel-wired/vpn-sorting note */
@@ -682,6 +729,540 @@ test_vpn_sorting (NetworkPanelFixture  *fixture,
 
 /*****************************************************************************/
 
+/* Same as in net-device-wifi.c */
+#define PERIODIC_WIFI_SCAN_TIMEOUT 15
+#define PERIODIC_WIFI_SCAN_TIMEOUT_MAX 120
+
+static GSource *
+find_scan_timer (NetDeviceWifi *wifi)
+{
+  /* The periodic scan is the only timeout of the device */
+  return g_main_context_find_source_by_funcs_user_data (NULL, &g_timeout_funcs, wifi);
+}
+
+static gint
+get_timer_interval (GSource *timer)
+{
+  /* Timeouts in seconds are rounded, so this is only accurate to a second */
+  return (g_source_get_ready_time (timer) - g_get_monotonic_time () + G_USEC_PER_SEC / 2) / G_USEC_PER_SEC;
+}
+
+static void
+wait_for_scan (NetworkPanelFixture *fixture)
+{
+  WAIT_DECL()
+
+  WAIT_DEVICE(fixture->main_wifi, 1, NM_DEVICE_WIFI_LAST_SCAN)
+  WAIT_FINISHED(5)
+}
+
+static void
+count_scan_cb (NMDeviceWifi *device,
+               GParamSpec   *pspec,
+               gpointer      user_data)
+{
+  guint *n_scans = user_data;
+
+  (*n_scans)++;
+}
+
+static void
+test_wifi_scan_backoff (NetworkPanelFixture  *fixture,
+                        gconstpointer         user_data)
+{
+  NetDeviceWifi *wifi;
+  GSource *timer;
+  gboolean scanning;
+  guint elapsed = 0;
+  guint interval;
+  guint n_timers = 0;
+  guint n_scans = 0;
+
+  wifi = NET_DEVICE_WIFI (find_widget_of_type (fixture->shell, NET_TYPE_DEVICE_WIFI));
+  g_assert_nonnull (wifi);
+
+  /* Start without a scan timer and without a scan in flight */
+  gtk_widget_hide (fixture->shell);
+  g_assert_null (find_scan_timer (wifi));
+
+  g_object_get (wifi, "scanning", &scanning, NULL);
+  if (scanning)
+    wait_for_scan (fixture);
+
+  g_signal_connect (fixture->main_wifi, "notify::" NM_DEVICE_WIFI_LAST_SCAN,
+                    G_CALLBACK (count_scan_cb), &n_scans);
+
+  /* Showing the list scans right away */
+  gtk_widget_show (fixture->shell);
+  wait_for_scan (fixture);
+  interval = PERIODIC_WIFI_SCAN_TIMEOUT;
+
+  /* Simulate an hour in which the APs do not change, firing each scan
+   * timer right away. */
+  while (elapsed < 3600) {
+    g_autoptr(GSource) fired = NULL;
+
+    timer = find_scan_timer (wifi);
+    g_assert_nonnull (timer);
+
+    /* The interval doubles with every scan, up to the maximum */
+    interval = MIN (interval * 2, PERIODIC_WIFI_SCAN_TIMEOUT_MAX);
+    g_assert_cmpint (ABS (get_timer_interval (timer) - (gint) interval), <=, 1);
+
+    fired = g_source_ref (timer);
+    g_source_set_ready_time (timer, 0);
+    wait_for_scan (fixture);
+
+    /* The timer that fired was not kept around next to the new one */
+    g_assert_true (g_source_is_destroyed (fired));
+
+    elapsed += interval;
+    n_timers++;
+  }
+
+  /* 30 s, 60 s and then every 2 minutes */
+  g_assert_cmpuint (interval, ==, PERIODIC_WIFI_SCAN_TIMEOUT_MAX);
+  g_assert_cmpuint (n_timers, ==, 32);
+  g_assert_cmpuint (n_scans, ==, n_timers + 1);
+
+  /* Nothing is scanned while the list is not visible, even if the APs change */
+  gtk_widget_hide (fixture->shell);
+  g_assert_null (find_scan_timer (wifi));
+
+  nmtst_add_wifi_aps (fixture->sinfo, fixture->main_wifi, "Scan ", 2);
+  g_assert_null (find_scan_timer (wifi));
+  g_assert_cmpuint (n_scans, ==, n_timers + 1);
+
+  /* Showing it again scans right away, and the changed APs reset the interval */
+  gtk_widget_show (fixture->shell);
+  wait_for_scan (fixture);
+  g_assert_cmpuint (n_scans, ==, n_timers + 2);
+
+  timer = find_scan_timer (wifi);
+  g_assert_nonnull (timer);
+  g_assert_cmpint (ABS (get_timer_interval (timer) - PERIODIC_WIFI_SCAN_TIMEOUT), <=, 1);
+
+  g_signal_handlers_disconnect_by_func (fixture->main_wifi, count_scan_cb, &n_scans);
+}
+
+/*****************************************************************************/
+
+static NMAccessPoint *
+find_access_point (NMDevice    *device,
+                   const gchar *ssid)
+{
+  const GPtrArray *aps;
+  guint i;
+
+  aps = nm_device_wifi_get_access_points (NM_DEVICE_WIFI (device));
+  for (i = 0; i < aps->len; i++) {
+    NMAccessPoint *ap = g_ptr_array_index (aps, i);
+    GBytes *ap_ssid = nm_access_point_get_ssid (ap);
+
+    if (ap_ssid &&
+        g_bytes_get_size (ap_ssid) == strlen (ssid) &&
+        memcmp (g_bytes_get_data (ap_ssid, NULL), ssid, strlen (ssid)) == 0)
+      return ap;
+  }
+
+  return NULL;
+}
+
+static CcWifiConnectionRow *
+find_access_point_row (GtkWidget     *list,
+                       NMAccessPoint *ap)
+{
+  g_autoptr(GList) rows = gtk_container_get_children (GTK_CONTAINER (list));
+  GList *node;
+
+  for (node = rows; node; node = node->next) {
+    if (cc_wifi_connection_row_has_access_point (node->data, ap))
+      return node->data;
+  }
+
+  return NULL;
+}
+
+static gboolean
+count_row_changed_cb (GtkListBoxRow *row,
+                      gpointer       user_data)
+{
+  GHashTable *changed = user_data;
+  guint count;
+
+  /* GtkListBox filters a row again every time it changed */
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (changed, row));
+  g_hash_table_insert (changed, row, GUINT_TO_POINTER (count + 1));
+
+  return TRUE;
+}
+
+static gboolean
+frame_tick_cb (GtkWidget     *widget,
+               GdkFrameClock *frame_clock,
+               gpointer       user_data)
+{
+  EventWaitInfo *info = user_data;
+
+  info->other_remaining--;
+  WAIT_CHECK_REMAINING()
+
+  return info->other_remaining > 0 ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+static void
+wait_for_frames (GtkWidget *widget,
+                 guint      frames)
+{
+  WAIT_DECL()
+
+  info.other_remaining = frames;
+  gtk_widget_add_tick_callback (widget, frame_tick_cb, &info, NULL);
+
+  WAIT_FINISHED(5)
+}
+
+static void
+test_wifi_strength_hysteresis (NetworkPanelFixture  *fixture,
+                               gconstpointer         user_data)
+{
+  g_autoptr(GHashTable) changed = NULL;
+  NMAccessPoint *aps[3];
+  CcWifiConnectionRow *rows[3];
+  GtkWidget *list;
+  guint i, j;
+
+  nmtst_add_wifi_aps (fixture->sinfo, fixture->main_wifi, "Strength ", G_N_ELEMENTS (aps));
+
+  list = find_widget_of_type (fixture->shell, CC_TYPE_WIFI_CONNECTION_LIST);
+  g_assert_nonnull (list);
+
+  for (i = 0; i < G_N_ELEMENTS (aps); i++) {
+    g_autofree gchar *ssid = g_strdup_printf ("Strength %u", i);
+
+    aps[i] = find_access_point (fixture->main_wifi, ssid);
+    g_assert_nonnull (aps[i]);
+    rows[i] = find_access_point_row (list, aps[i]);
+    g_assert_nonnull (rows[i]);
+  }
+
+  /* All APs start out with the same strength, so they are sorted by name */
+  for (i = 0; i < G_N_ELEMENTS (rows); i++)
+    g_assert_cmpint (gtk_list_box_row_get_index (GTK_LIST_BOX_ROW (rows[i])), ==, i);
+
+  changed = g_hash_table_new (NULL, NULL);
+  gtk_list_box_set_filter_func (GTK_LIST_BOX (list), count_row_changed_cb, changed, NULL);
+  g_hash_table_remove_all (changed);
+
+  /* Changes below the hysteresis do not resort the list, nor touch the rows
+   * at all. Otherwise "Strength 1" would be sorted first now. */
+  nmtst_set_wifi_ap_strength (fixture->sinfo, fixture->main_wifi, aps[0], 48);
+  nmtst_set_wifi_ap_strength (fixture->sinfo, fixture->main_wifi, aps[1], 54);
+  wait_for_frames (list, 2);
+
+  g_assert_cmpuint (g_hash_table_size (changed), ==, 0);
+  for (i = 0; i < G_N_ELEMENTS (rows); i++)
+    g_assert_cmpint (gtk_list_box_row_get_index (GTK_LIST_BOX_ROW (rows[i])), ==, i);
+
+  /* A burst of changes within one frame only changes every row once. Hold
+   * back the notifications until all APs have their new strength, then
+   * deliver several of them for each AP at once. */
+  for (i = 0; i < G_N_ELEMENTS (aps); i++)
+    g_signal_handlers_block_matched (aps[i], G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, list);
+
+  nmtst_set_wifi_ap_strength (fixture->sinfo, fixture->main_wifi, aps[0], 20);
+  nmtst_set_wifi_ap_strength (fixture->sinfo, fixture->main_wifi, aps[1], 70);
+  nmtst_set_wifi_ap_strength (fixture->sinfo, fixture->main_wifi, aps[2], 90);
+
+  for (i = 0; i < G_N_ELEMENTS (aps); i++) {
+    g_signal_handlers_unblock_matched (aps[i], G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, list);
+    for (j = 0; j < 3; j++)
+      g_object_notify (G_OBJECT (aps[i]), NM_ACCESS_POINT_STRENGTH);
+  }
+  wait_for_frames (list, 2);
+
+  for (i = 0; i < G_N_ELEMENTS (rows); i++)
+    g_assert_cmpuint (GPOINTER_TO_UINT (g_hash_table_lookup (changed, rows[i])), ==, 1);
+
+  /* And the list is now sorted by strength */
+  for (i = 0; i < G_N_ELEMENTS (rows); i++)
+    g_assert_cmpint (gtk_list_box_row_get_index (GTK_LIST_BOX_ROW (rows[i])), ==, G_N_ELEMENTS (rows) - 1 - i);
+
+  gtk_list_box_set_filter_func (GTK_LIST_BOX (list), NULL, NULL, NULL);
+}
+
+static void
+test_wifi_ssid_rename (NetworkPanelFixture  *fixture,
+                       gconstpointer         user_data)
+{
+  g_autoptr(GHashTable) changed = NULL;
+  g_autoptr(GList) children = NULL;
+  CcWifiConnectionRow *row;
+  NMAccessPoint *ap;
+  GtkWidget *list;
+
+  nmtst_add_wifi_aps (fixture->sinfo, fixture->main_wifi, "Rename ", 2);
+
+  list = find_widget_of_type (fixture->shell, CC_TYPE_WIFI_CONNECTION_LIST);
+  g_assert_nonnull (list);
+
+  ap = find_access_point (fixture->main_wifi, "Rename 0");
+  g_assert_nonnull (ap);
+  row = find_access_point_row (list, ap);
+  g_assert_nonnull (row);
+  g_assert_nonnull (find_label (GTK_WIDGET (row), "Rename 0"));
+  g_assert_cmpint (gtk_list_box_row_get_index (GTK_LIST_BOX_ROW (row)), ==, 0);
+
+  changed = g_hash_table_new (NULL, NULL);
+  gtk_list_box_set_filter_func (GTK_LIST_BOX (list), count_row_changed_cb, changed, NULL);
+  g_hash_table_remove_all (changed);
+
+  /* Renaming an AP that is alone in its row keeps the row, which now shows
+   * the new SSID and moves behind "Rename 1". */
+  nmtst_set_wifi_ap_ssid (fixture->sinfo, fixture->main_wifi, ap, "Rename 2");
+
+  g_assert_true (find_access_point_row (list, ap) == row);
+  g_assert_true (gtk_widget_get_parent (GTK_WIDGET (row)) == list);
+  g_assert_nonnull (find_label (GTK_WIDGET (row), "Rename 2"));
+  g_assert_null (find_label (list, "Rename 0"));
+  g_assert_cmpint (gtk_list_box_row_get_index (GTK_LIST_BOX_ROW (row)), ==, 1);
+
+  /* It was changed in place instead of being removed and added again */
+  children = gtk_container_get_children (GTK_CONTAINER (list));
+  g_assert_cmpuint (g_list_length (children), ==, 2);
+  g_assert_cmpuint (g_hash_table_size (changed), ==, 1);
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_hash_table_lookup (changed, row)), ==, 1);
+
+  gtk_list_box_set_filter_func (GTK_LIST_BOX (list), NULL, NULL, NULL);
+}
+
+/*****************************************************************************/
+
+/* Performance scenarios, only run with -m perf. They report the total time,
+ * the longest main loop stall and the RSS growth of each scenario. */
+
+#define PERF_TICK_INTERVAL_MS 5
+
+typedef struct {
+  gint64 start_time;
+  gint64 last_tick;
+  gint64 max_stall;
+  glong  start_rss;
+  guint  tick_id;
+} PerfMonitor;
+
+static glong
+get_rss_kb (void)
+{
+  g_autofree gchar *status = NULL;
+  const gchar *line;
+
+  if (!g_file_get_contents ("/proc/self/status", &status, NULL, NULL))
+    return 0;
+
+  line = strstr (status, "VmRSS:");
+  if (!line)
+    return 0;
+
+  return (glong) g_ascii_strtoull (line + strlen ("VmRSS:"), NULL, 10);
+}
+
+static gboolean
+perf_monitor_tick_cb (gpointer user_data)
+{
+  PerfMonitor *monitor = user_data;
+  gint64 now = g_get_monotonic_time ();
+
+  if (monitor->last_tick > 0)
+    monitor->max_stall = MAX (monitor->max_stall, now - monitor->last_tick);
+  monitor->last_tick = now;
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+perf_monitor_start (PerfMonitor *monitor)
+{
+  *monitor = (PerfMonitor) { 0 };
+
+  monitor->start_time = g_get_monotonic_time ();
+  monitor->start_rss = get_rss_kb ();
+  monitor->tick_id = g_timeout_add (PERF_TICK_INTERVAL_MS, perf_monitor_tick_cb, monitor);
+}
+
+/* Call before the test itself blocks on the mock service, so that this is
+ * not counted as a stall. */
+static void
+perf_monitor_skip (PerfMonitor *monitor)
+{
+  monitor->last_tick = 0;
+}
+
+static void
+perf_monitor_report (PerfMonitor *monitor,
+                     const gchar *scenario)
+{
+  g_clear_handle_id (&monitor->tick_id, g_source_remove);
+
+  g_test_message ("%s: %.1f ms total, %.1f ms longest main loop stall, %+ld kB RSS",
+                  scenario,
+                  (g_get_monotonic_time () - monitor->start_time) / 1000.0,
+                  monitor->max_stall / 1000.0,
+                  get_rss_kb () - monitor->start_rss);
+}
+
+static void
+perf_add_cb (GObject       *object,
+             GAsyncResult  *result,
+             gpointer       user_data)
+{
+  EventWaitInfo *info = user_data;
+  g_autoptr(GError) error = NULL;
+  NMRemoteConnection *rc;
+
+  rc = nm_client_add_connection_finish (NM_CLIENT (object), result, &error);
+  g_assert_no_error (error);
+  g_object_unref (rc);
+
+  info->other_remaining--;
+  WAIT_CHECK_REMAINING()
+}
+
+static void
+add_connections (NetworkPanelFixture *fixture,
+                 const gchar         *type,
+                 const gchar         *id_prefix,
+                 guint                count)
+{
+  guint i;
+  WAIT_DECL()
+
+  for (i = 0; i < count; i++) {
+    g_autofree gchar *id = g_strdup_printf ("%s%u", id_prefix, i);
+    NMSettingConnection *connsetting;
+    NMConnection *conn;
+
+    conn = nmtst_create_minimal_connection (id, NULL, type, &connsetting);
+
+    if (g_str_equal (type, NM_SETTING_VPN_SETTING_NAME)) {
+      g_object_set (G_OBJECT (nm_connection_get_setting_vpn (conn)),
+                    NM_SETTING_VPN_SERVICE_TYPE, "org.freedesktop.NetworkManager.vpnc",
+                    NULL);
+    } else if (g_str_equal (type, NM_SETTING_WIRELESS_SETTING_NAME)) {
+      g_autoptr(GBytes) ssid = g_bytes_new (id, strlen (id));
+
+      g_object_set (G_OBJECT (nm_connection_get_setting_wireless (conn)),
+                    NM_SETTING_WIRELESS_SSID, ssid,
+                    NULL);
+    }
+
+    nm_client_add_connection_async (fixture->client, conn, TRUE, NULL, perf_add_cb, &info);
+    g_object_unref (conn);
+  }
+
+  info.other_remaining = count;
+  WAIT_CLIENT(fixture->client, count, NM_CLIENT_CONNECTION_ADDED);
+
+  WAIT_FINISHED(60)
+}
+
+static void
+remove_all_connections (NetworkPanelFixture *fixture)
+{
+  const GPtrArray *connections;
+  guint count;
+  guint i;
+  WAIT_DECL()
+
+  connections = nm_client_get_connections (fixture->client);
+  count = connections->len;
+
+  for (i = 0; i < count; i++)
+    nm_remote_connection_delete_async (g_ptr_array_index (connections, i), NULL, delete_cb, &info);
+
+  info.other_remaining = count;
+  WAIT_CLIENT(fixture->client, count, NM_CLIENT_CONNECTION_REMOVED);
+
+  WAIT_FINISHED(60)
+}
+
+static void
+test_perf_many_connections (NetworkPanelFixture  *fixture,
+                            gconstpointer         user_data)
+{
+  PerfMonitor monitor;
+
+  perf_monitor_start (&monitor);
+  add_connections (fixture, NM_SETTING_WIRED_SETTING_NAME, "Wired ", 300);
+  perf_monitor_report (&monitor, "Adding 300 wired connections");
+}
+
+static void
+test_perf_vpn_churn (NetworkPanelFixture  *fixture,
+                     gconstpointer         user_data)
+{
+  PerfMonitor monitor;
+  guint i;
+
+  perf_monitor_start (&monitor);
+  for (i = 0; i < 5; i++) {
+    add_connections (fixture, NM_SETTING_VPN_SETTING_NAME, "VPN ", 50);
+    remove_all_connections (fixture);
+  }
+  perf_monitor_report (&monitor, "Adding and removing 50 VPN connections 5 times");
+
+  g_assert_null (find_label (fixture->shell, "VPN 0 VPN"));
+}
+
+static void
+test_perf_device_churn (NetworkPanelFixture  *fixture,
+                        gconstpointer         user_data)
+{
+  PerfMonitor monitor;
+  guint i;
+
+  perf_monitor_start (&monitor);
+  for (i = 0; i < 50; i++) {
+    g_autofree gchar *iface = g_strdup_printf ("eth%u", 2000 + i);
+    g_autofree gchar *hwaddr = g_strdup_printf ("52:54:00:ab:%02x:%02x", i / 256, i % 256);
+    NMDevice *device;
+
+    perf_monitor_skip (&monitor);
+    device = nmtstc_service_add_wired_device (fixture->sinfo, fixture->client, iface, hwaddr, NULL);
+
+    perf_monitor_skip (&monitor);
+    nmtst_remove_device (fixture->sinfo, fixture->client, device);
+  }
+  perf_monitor_report (&monitor, "Adding and removing 50 wired devices");
+}
+
+static void
+test_perf_wifi_aps (NetworkPanelFixture  *fixture,
+                    gconstpointer         user_data)
+{
+  PerfMonitor monitor;
+  guint i;
+
+  perf_monitor_start (&monitor);
+  add_connections (fixture, NM_SETTING_WIRELESS_SETTING_NAME, "Network ", 200);
+  perf_monitor_report (&monitor, "Adding 200 Wi-Fi connections");
+
+  /* The second batch has the same SSIDs, so these APs are grouped */
+  perf_monitor_start (&monitor);
+  nmtst_add_wifi_aps (fixture->sinfo, fixture->main_wifi, "Network ", 1000);
+  nmtst_add_wifi_aps (fixture->sinfo, fixture->main_wifi, "Network ", 1000);
+  perf_monitor_report (&monitor, "Adding 2000 APs");
+
+  perf_monitor_start (&monitor);
+  for (i = 0; i < 10; i++)
+    nmtst_randomize_wifi_ap_strengths (fixture->sinfo, fixture->main_wifi, i);
+  perf_monitor_report (&monitor, "Changing the strength of 2000 APs 10 times");
+
+  g_assert_nonnull (find_label (fixture->shell, "Network 999"));
+}
+
+/*****************************************************************************/
+
 int
 main (int argc, char **argv)
 {
@@ -783,6 +1364,57 @@ main (int argc, char **argv)
               fixture_tear_down);
 #endif
 
+  g_test_add ("/network-panel-wifi/scan-backoff",
+              NetworkPanelFixture,
+              NULL,
+              fixture_set_up_wifi,
+              test_wifi_scan_backoff,
+              fixture_tear_down);
+
+  g_test_add ("/network-panel-wifi/strength-hysteresis",
+              NetworkPanelFixture,
+              NULL,
+              fixture_set_up_wifi,
+              test_wifi_strength_hysteresis,
+              fixture_tear_down);
+
+  g_test_add ("/network-panel-wifi/ssid-rename",
+              NetworkPanelFixture,
+              NULL,
+              fixture_set_up_wifi,
+              test_wifi_ssid_rename,
+              fixture_tear_down);
+
+  if (g_test_perf ()) {
+    g_test_add ("/network-panel-perf/many-connections",
+                NetworkPanelFixture,
+                NULL,
+                fixture_set_up_wired,
+                test_perf_many_connections,
+                fixture_tear_down);
+
+    g_test_add ("/network-panel-perf/vpn-churn",
+                NetworkPanelFixture,
+                NULL,
+                fixture_set_up_empty,
+                test_perf_vpn_churn,
+                fixture_tear_down);
+
+    g_test_add ("/network-panel-perf/device-churn",
+                NetworkPanelFixture,
+                NULL,
+                fixture_set_up_empty,
+                test_perf_device_churn,
+                fixture_tear_down);
+
+    g_test_add ("/network-panel-perf/wifi-aps",
+                NetworkPanelFixture,
+                NULL,
+                fixture_set_up_wifi,
+                test_perf_wifi_aps,
+                fixture_tear_down);
+  }
+
   return g_test_run ();
 }
 
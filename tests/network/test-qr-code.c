@@ -0,0 +1,192 @@
+/* -*- mode: c; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+/* test-qr-code.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#undef NDEBUG
+#undef G_DISABLE_ASSERT
+#undef G_DISABLE_CHECKS
+#undef G_DISABLE_CAST_CHECKS
+#undef G_LOG_DOMAIN
+
+#include <glib.h>
+
+/* Including ‘.c’ file to test static functions */
+#include "cc-qr-code.c"
+
+/* Renders the QR code with one cairo rectangle per module */
+static cairo_surface_t *
+render_reference (const gchar *text,
+                  gint         size,
+                  gint         scale)
+{
+  uint8_t qr_code[qrcodegen_BUFFER_LEN_FOR_VERSION (qrcodegen_VERSION_MAX)];
+  uint8_t temp_buf[qrcodegen_BUFFER_LEN_FOR_VERSION (qrcodegen_VERSION_MAX)];
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  gint pixel_size, padding, qr_size;
+
+  g_assert_true (qrcodegen_encodeText (text, temp_buf, qr_code,
+                                       qrcodegen_Ecc_LOW,
+                                       qrcodegen_VERSION_MIN,
+                                       qrcodegen_VERSION_MAX,
+                                       qrcodegen_Mask_AUTO,
+                                       FALSE));
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24, size * scale, size * scale);
+  cairo_surface_set_device_scale (surface, scale, scale);
+  cr = cairo_create (surface);
+  cairo_set_antialias (cr, CAIRO_ANTIALIAS_NONE);
+
+  cairo_set_source_rgba (cr, 1, 1, 1, 1);
+  cairo_rectangle (cr, 0, 0, size * scale, size * scale);
+  cairo_fill (cr);
+
+  qr_size = qrcodegen_getSize (qr_code);
+  get_module_layout (size, qr_size, &pixel_size, &padding);
+
+  cairo_set_source_rgba (cr, 0, 0, 0, 1);
+  for (int row = 0; row < qr_size; row++)
+    {
+      for (int column = 0; column < qr_size; column++)
+        {
+          if (!qrcodegen_getModule (qr_code, row, column))
+            continue;
+
+          cairo_rectangle (cr,
+                           column * pixel_size + padding,
+                           row * pixel_size + padding,
+                           pixel_size, pixel_size);
+          cairo_fill (cr);
+        }
+    }
+
+  cairo_destroy (cr);
+  cairo_surface_flush (surface);
+
+  return surface;
+}
+
+static void
+assert_surfaces_equal (cairo_surface_t *a,
+                       cairo_surface_t *b)
+{
+  guchar *data_a, *data_b;
+  gint width, height;
+
+  width = cairo_image_surface_get_width (a);
+  height = cairo_image_surface_get_height (a);
+  g_assert_cmpint (width, ==, cairo_image_surface_get_width (b));
+  g_assert_cmpint (height, ==, cairo_image_surface_get_height (b));
+
+  data_a = cairo_image_surface_get_data (a);
+  data_b = cairo_image_surface_get_data (b);
+
+  for (gint y = 0; y < height; y++)
+    {
+      guint32 *line_a = (guint32 *) (data_a + y * cairo_image_surface_get_stride (a));
+      guint32 *line_b = (guint32 *) (data_b + y * cairo_image_surface_get_stride (b));
+
+      /* The upper byte of RGB24 pixels is unused */
+      for (gint x = 0; x < width; x++)
+        g_assert_cmphex (line_a[x] & 0xffffff, ==, line_b[x] & 0xffffff);
+    }
+}
+
+static gchar *
+get_test_text (gsize length)
+{
+  GString *text = g_string_new ("WIFI:S:");
+
+  while (text->len < length)
+    g_string_append_c (text, 'a' + text->len % 26);
+
+  return g_string_free (text, FALSE);
+}
+
+static void
+test_qr_code_surface (void)
+{
+  const gsize lengths[] = { 10, 60, 200, 700, 2000 };
+  const gint sizes[] = { 20, 100, 180 };
+
+  for (guint i = 0; i < G_N_ELEMENTS (lengths); i++)
+    for (guint j = 0; j < G_N_ELEMENTS (sizes); j++)
+      for (gint scale = 1; scale <= 2; scale++)
+        {
+          g_autoptr(CcQrCode) qr_code = cc_qr_code_new ();
+          g_autofree gchar *text = get_test_text (lengths[i]);
+          cairo_surface_t *surface, *reference;
+
+          cc_qr_code_set_text (qr_code, text);
+          surface = cc_qr_code_get_surface (qr_code, sizes[j], scale);
+          g_assert_nonnull (surface);
+
+          reference = render_reference (text, sizes[j], scale);
+          assert_surfaces_equal (surface, reference);
+          cairo_surface_destroy (reference);
+
+          /* The surface is cached until any parameter changes */
+          g_assert_true (cc_qr_code_get_surface (qr_code, sizes[j], scale) == surface);
+          g_assert_false (cc_qr_code_set_text (qr_code, text));
+        }
+}
+
+static void
+test_qr_code_perf (void)
+{
+  const gsize lengths[] = { 10, 200, 2000 };
+
+  if (!g_test_perf ())
+    return;
+
+  for (guint i = 0; i < G_N_ELEMENTS (lengths); i++)
+    {
+      g_autofree gchar *text = get_test_text (lengths[i]);
+      gdouble reference_time, surface_time;
+
+      g_test_timer_start ();
+      for (gint n = 0; n < 100; n++)
+        cairo_surface_destroy (render_reference (text, 180, 2));
+      reference_time = g_test_timer_elapsed ();
+
+      g_test_timer_start ();
+      for (gint n = 0; n < 100; n++)
+        {
+          g_autoptr(CcQrCode) qr_code = cc_qr_code_new ();
+
+          cc_qr_code_set_text (qr_code, text);
+          g_assert_nonnull (cc_qr_code_get_surface (qr_code, 180, 2));
+        }
+      surface_time = g_test_timer_elapsed ();
+
+      g_test_message ("%" G_GSIZE_FORMAT " characters: %.2f ms with cairo fills, %.2f ms with row fills",
+                      lengths[i], reference_time * 10, surface_time * 10);
+    }
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/network/qr-code/surface", test_qr_code_surface);
+  g_test_add_func ("/network/qr-code/perf", test_qr_code_perf);
+
+  return g_test_run ();
+}
@@ -37,12 +37,13 @@ test_canonicalization (gconstpointer data)
           PpPrintDevice  *device;
           gchar         **already_present_printers;
           gchar          *canonicalized_name;
-          GList          *devices = NULL;
+          DeviceNames    *device_names;
 
           already_present_printers = g_strsplit (items[0], " ", -1);
 
+          device_names = device_names_new ();
           for (j = 0; already_present_printers[j] != NULL; j++)
-            devices = g_list_append (devices, g_strdup (already_present_printers[j]));
+            device_names_add (device_names, already_present_printers[j]);
 
           device = g_object_new (PP_TYPE_PRINT_DEVICE,
                                  "device-id", items[1],
@@ -52,7 +53,7 @@ test_canonicalization (gconstpointer data)
                                  NULL);
 
           canonicalized_name =
-            canonicalize_device_name (devices, NULL, NULL, 0, device);
+            canonicalize_device_name (device_names, device);
 
           if (g_strcmp0 (canonicalized_name, items[5]) != 0)
             {
@@ -68,7 +69,7 @@ test_canonicalization (gconstpointer data)
 
           g_free (canonicalized_name);
           g_object_unref (device);
-          g_list_free_full (devices, (GDestroyNotify) g_free);
+          device_names_free (device_names);
           g_strfreev (already_present_printers);
         }
       else
@@ -83,6 +84,62 @@ test_canonicalization (gconstpointer data)
   g_strfreev (lines);
 }
 
+#define N_SIMILAR_DEVICES 5000
+
+static void
+test_canonicalization_scaling (void)
+{
+  DeviceNames *device_names;
+  gint64       start_time;
+  guint        i;
+
+  device_names = device_names_new ();
+
+  start_time = g_get_monotonic_time ();
+
+  /* Every device gets the next free suffix of the same name */
+  for (i = 0; i < N_SIMILAR_DEVICES; i++)
+    {
+      g_autoptr(PpPrintDevice) device = NULL;
+      g_autofree gchar *canonicalized_name = NULL;
+      g_autofree gchar *expected_name = NULL;
+
+      device = g_object_new (PP_TYPE_PRINT_DEVICE,
+                             "device-make-and-model", "HP LaserJet 4000 Series",
+                             NULL);
+
+      canonicalized_name = canonicalize_device_name (device_names, device);
+
+      if (i == 0)
+        expected_name = g_strdup ("HP-LaserJet-4000");
+      else
+        expected_name = g_strdup_printf ("HP-LaserJet-4000-%u", i + 1);
+
+      g_assert_cmpstr (canonicalized_name, ==, expected_name);
+
+      device_names_add (device_names, canonicalized_name);
+    }
+
+  g_debug ("Canonicalized %u similar names in %" G_GINT64_FORMAT " ms",
+           N_SIMILAR_DEVICES, (g_get_monotonic_time () - start_time) / 1000);
+
+  /* A released suffix is reused */
+  device_names_remove (device_names, "HP-LaserJet-4000-7");
+  {
+    g_autoptr(PpPrintDevice) device = NULL;
+    g_autofree gchar *canonicalized_name = NULL;
+
+    device = g_object_new (PP_TYPE_PRINT_DEVICE,
+                           "device-make-and-model", "HP LaserJet 4000 Series",
+                           NULL);
+
+    canonicalized_name = canonicalize_device_name (device_names, device);
+    g_assert_cmpstr (canonicalized_name, ==, "HP-LaserJet-4000-7");
+  }
+
+  device_names_free (device_names);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -114,6 +171,7 @@ main (int argc, char **argv)
     }
 
   g_test_add_data_func ("/printers/canonicalization", contents, test_canonicalization);
+  g_test_add_func ("/printers/canonicalization-scaling", test_canonicalization_scaling);
 
   return g_test_run ();
 }
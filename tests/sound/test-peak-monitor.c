@@ -0,0 +1,153 @@
+/* -*- mode: c; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+/* test-peak-monitor.c
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#undef NDEBUG
+#undef G_DISABLE_ASSERT
+#undef G_DISABLE_CHECKS
+#undef G_DISABLE_CAST_CHECKS
+#undef G_LOG_DOMAIN
+
+#include <glib.h>
+
+/* Including ‘.c’ file to test static functions */
+#include "cc-peak-monitor.c"
+
+#define MAX_SAMPLES 67
+
+/* Finds the peak one sample at a time, without any room for vectorizing */
+static gfloat
+get_peak_reference (const gfloat *samples,
+                    gsize         n_samples)
+{
+  gfloat peak = 0.0f;
+  gsize i;
+
+  for (i = 0; i < n_samples; i++)
+    {
+      gfloat value = samples[i] < 0.0f ? -samples[i] : samples[i];
+
+      if (value > peak)
+        peak = value;
+    }
+
+  return peak;
+}
+
+static void
+fill_random (gfloat  *samples,
+             gsize    n_samples,
+             gdouble  min,
+             gdouble  max)
+{
+  gsize i;
+
+  for (i = 0; i < n_samples; i++)
+    samples[i] = g_test_rand_double_range (min, max);
+}
+
+static void
+test_empty (void)
+{
+  gfloat samples[1] = { -1.0f };
+
+  g_assert_cmpfloat (get_peak (samples, 0), ==, 0.0f);
+}
+
+static void
+test_negative (void)
+{
+  gfloat samples[MAX_SAMPLES];
+  gsize n;
+
+  /* The peak is the largest magnitude, also if all samples are negative */
+  for (n = 1; n <= MAX_SAMPLES; n++)
+    {
+      fill_random (samples, n, -1.0, 0.0);
+
+      g_assert_cmpfloat (get_peak (samples, n), ==, get_peak_reference (samples, n));
+      g_assert_cmpfloat (get_peak (samples, n), >, 0.0f);
+    }
+}
+
+static void
+test_first_last (void)
+{
+  gfloat samples[MAX_SAMPLES];
+  gsize n;
+
+  /* Catches loops that skip the start or the remainder of the buffer */
+  for (n = 2; n <= MAX_SAMPLES; n++)
+    {
+      fill_random (samples, n, -0.5, 0.5);
+      samples[0] = 0.75f;
+      g_assert_cmpfloat (get_peak (samples, n), ==, 0.75f);
+      samples[0] = -0.75f;
+      g_assert_cmpfloat (get_peak (samples, n), ==, 0.75f);
+
+      fill_random (samples, n, -0.5, 0.5);
+      samples[n - 1] = 0.75f;
+      g_assert_cmpfloat (get_peak (samples, n), ==, 0.75f);
+      samples[n - 1] = -0.75f;
+      g_assert_cmpfloat (get_peak (samples, n), ==, 0.75f);
+    }
+}
+
+static void
+test_odd_lengths (void)
+{
+  gfloat samples[MAX_SAMPLES];
+  gsize n;
+  guint i;
+
+  for (n = 1; n <= MAX_SAMPLES; n += 2)
+    {
+      for (i = 0; i < 10; i++)
+        {
+          fill_random (samples, n, -1.0, 1.0);
+          g_assert_cmpfloat (get_peak (samples, n), ==, get_peak_reference (samples, n));
+        }
+    }
+}
+
+static void
+test_unaligned (void)
+{
+  gfloat samples[MAX_SAMPLES + 1];
+  gsize n;
+
+  /* Buffers from PulseAudio do not need to start on a vector boundary */
+  fill_random (samples, G_N_ELEMENTS (samples), -1.0, 1.0);
+  for (n = 0; n < MAX_SAMPLES; n++)
+    g_assert_cmpfloat (get_peak (samples + 1, n), ==, get_peak_reference (samples + 1, n));
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/sound/peak-monitor/empty", test_empty);
+  g_test_add_func ("/sound/peak-monitor/negative", test_negative);
+  g_test_add_func ("/sound/peak-monitor/first-last", test_first_last);
+  g_test_add_func ("/sound/peak-monitor/odd-lengths", test_odd_lengths);
+  g_test_add_func ("/sound/peak-monitor/unaligned", test_unaligned);
+
+  return g_test_run ();
+}